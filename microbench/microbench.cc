@@ -0,0 +1,436 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../src/chess/board.h"
+#include "../src/chess/move_gen.h"
+#include "../src/engine/evaluation/evaluation.h"
+#include "../src/engine/evaluation/nnue/accumulator.h"
+#include "../src/engine/evaluation/nnue/nnue.h"
+#include "../src/engine/search/move_picker.h"
+#include "../src/engine/search/stack.h"
+#include "../src/engine/search/transpo.h"
+#include "../src/tests/positions.h"
+#include "../src/utils/perf_counters.h"
+#include "../src/utils/string.h"
+
+namespace {
+
+// Each kernel is timed over several samples and the median is reported, which
+// filters out samples disturbed by interrupts or frequency changes
+constexpr int kSamples = 7;
+// Batches of a kernel are repeated until a sample takes at least this long, so
+// that the overhead of reading the clocks is negligible
+constexpr auto kMinSampleTime = std::chrono::milliseconds(25);
+
+constexpr std::size_t kTTSize = 64;
+constexpr int kTTProbeKeys = 1 << 16;
+
+// Number of moves played from each position before timing the repetition
+// detection, which gives it a history to scan
+constexpr int kRepetitionPlies = 16;
+
+[[nodiscard]] inline U64 ReadCycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+[[nodiscard]] constexpr bool HasCycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Prevents the compiler from optimizing away the computation of a value that
+// is otherwise unused
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result {
+  double ns_per_op;
+  double cycles_per_op;
+  // Hardware events over all of the samples, and the operations they cover
+  perf::Counts counts;
+  U64 counted_ops;
+};
+
+template <typename T>
+[[nodiscard]] T Median(std::vector<T> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// Times a kernel that returns the number of operations it performed per call,
+// counting hardware events during the samples if the counters are open
+template <typename Kernel>
+[[nodiscard]] Result Measure(Kernel &&kernel, perf::CounterGroup &counters) {
+  using namespace std::chrono;
+
+  // Warm up the caches while finding how many calls make up a sample
+  U64 calls = 1;
+  while (true) {
+    const auto start_time = steady_clock::now();
+    for (U64 i = 0; i < calls; i++) DoNotOptimize(kernel());
+    if (steady_clock::now() - start_time >= kMinSampleTime) break;
+    calls *= 2;
+  }
+
+  std::vector<double> ns_per_op, cycles_per_op;
+  U64 counted_ops = 0;
+
+  counters.Reset();
+  counters.Enable();
+  for (int sample = 0; sample < kSamples; sample++) {
+    U64 ops = 0;
+
+    const auto start_time = steady_clock::now();
+    const U64 start_cycles = ReadCycleCounter();
+    for (U64 i = 0; i < calls; i++) ops += kernel();
+    const U64 cycles = ReadCycleCounter() - start_cycles;
+    const auto elapsed =
+        duration_cast<nanoseconds>(steady_clock::now() - start_time);
+
+    counted_ops += ops;
+    ops = std::max<U64>(ops, 1);
+    ns_per_op.push_back(static_cast<double>(elapsed.count()) / ops);
+    cycles_per_op.push_back(static_cast<double>(cycles) / ops);
+  }
+
+  counters.Disable();
+
+  return {Median(ns_per_op),
+          Median(cycles_per_op),
+          counters.Read(),
+          std::max<U64>(counted_ops, 1)};
+}
+
+void PrintHeader(bool with_counters) {
+  std::string line =
+      fmt::format("{:<44} {:>10} {:>10}", "kernel", "ns/op", "cycles/op");
+  if (with_counters) {
+    line += fmt::format(" {:>6}", "IPC");
+    for (int event = perf::kInstructions; event < perf::kNumEvents; event++) {
+      line += fmt::format(" {:>13}", perf::kEventNames[event]);
+    }
+  }
+  fmt::println("{}", line);
+}
+
+// Prints the times per operation, followed by the hardware events per
+// operation if any were counted. The cycles column is always the time stamp
+// counter, which ticks at a constant rate regardless of the clock speed
+void PrintResult(std::string_view name, const Result &result) {
+  std::string line;
+  if (HasCycleCounter()) {
+    line = fmt::format("{:<44} {:>10.1f} {:>10.1f}",
+                       name,
+                       result.ns_per_op,
+                       result.cycles_per_op);
+  } else {
+    line = fmt::format("{:<44} {:>10.1f} {:>10}", name, result.ns_per_op, "-");
+  }
+
+  if (result.counts.AnyAvailable()) {
+    const auto &counts = result.counts;
+    if (counts.available[perf::kCycles] &&
+        counts.available[perf::kInstructions]) {
+      line += fmt::format(" {:>6.2f}", counts.InstructionsPerCycle());
+    } else {
+      line += fmt::format(" {:>6}", "n/a");
+    }
+
+    for (int event = perf::kInstructions; event < perf::kNumEvents; event++) {
+      if (counts.available[event]) {
+        line += fmt::format(
+            " {:>13.2f}",
+            static_cast<double>(counts.values[event]) / result.counted_ops);
+      } else {
+        line += fmt::format(" {:>13}", "n/a");
+      }
+    }
+  }
+
+  fmt::println("{}", line);
+}
+
+[[nodiscard]] std::vector<Move> LegalMoves(const Board &board,
+                                           bool noisy_only = false) {
+  const auto moves =
+      noisy_only ? move_gen::GenerateMoves<MoveGenType::kLegalNoisy>(board)
+                 : move_gen::GenerateMoves<MoveGenType::kLegalAll>(board);
+
+  std::vector<Move> legal_moves;
+  for (int i = 0; i < moves.Size(); i++) legal_moves.push_back(moves[i]);
+  return legal_moves;
+}
+
+[[nodiscard]] std::size_t CountMoves(
+    const std::vector<std::vector<Move>> &moves) {
+  std::size_t count = 0;
+  for (const auto &position_moves : moves) count += position_moves.size();
+  return count;
+}
+
+// Plays quiet moves that don't reset the fifty move clock for as long as
+// possible, so that the repetition detection has a history to go through
+void PlayReversibleMoves(Board &board, int plies) {
+  for (int ply = 0; ply < plies; ply++) {
+    const auto &state = board.GetState();
+
+    std::vector<Move> reversible_moves;
+    for (const auto move : LegalMoves(board)) {
+      if (!move.IsNoisy(state) &&
+          state.GetPieceType(move.GetFrom()) != PieceType::kPawn) {
+        reversible_moves.push_back(move);
+      }
+    }
+
+    if (reversible_moves.empty()) return;
+    board.MakeMove(reversible_moves[(ply * 7) % reversible_moves.size()]);
+  }
+}
+
+}  // namespace
+
+// Times the engine's hot kernels in isolation over the bench and perft
+// positions. An optional argument only runs the kernels whose name contains it
+int main(int arg_count, char **args) {
+  const std::string filter = arg_count > 1 ? args[1] : "";
+
+  nnue::LoadFromIncBin();
+
+  std::vector<std::string> fens(tests::kBenchFens.begin(),
+                                tests::kBenchFens.end());
+  for (const auto &perft_test : tests::kPerftSuite) {
+    fens.push_back(SplitString(perft_test, ';')[0]);
+  }
+
+  std::vector<std::unique_ptr<Board>> boards;
+  std::vector<std::vector<Move>> legal_moves, noisy_moves;
+  for (const auto &fen : fens) {
+    auto board = std::make_unique<Board>();
+    board->SetFromFen(fen);
+    legal_moves.push_back(LegalMoves(*board));
+    noisy_moves.push_back(LegalMoves(*board, true));
+    boards.push_back(std::move(board));
+  }
+
+  std::vector<std::unique_ptr<Board>> repetition_boards;
+  for (const auto &fen : fens) {
+    auto board = std::make_unique<Board>();
+    board->SetFromFen(fen);
+    PlayReversibleMoves(*board, kRepetitionPlies);
+    repetition_boards.push_back(std::move(board));
+  }
+
+  const auto history = std::make_unique<search::history::History>();
+  const auto stack = std::make_unique<search::Stack>();
+
+  auto refresh_accumulator = std::make_unique<nnue::Accumulator>();
+  auto refresh_entry = std::make_unique<nnue::AccumulatorEntry>();
+
+  search::TranspositionTable transposition_table(kTTSize);
+  std::mt19937_64 rng(0);
+  std::vector<U64> tt_keys(kTTProbeKeys);
+  for (auto &key : tt_keys) key = rng();
+  // Fill the table with every other key so that half of the probes hit
+  for (int i = 0; i < kTTProbeKeys; i += 2) {
+    const auto probe = transposition_table.Probe(tt_keys[i]);
+    transposition_table.Save(
+        probe,
+        search::TranspositionTableEntry(
+            i % 32,
+            search::TranspositionTableEntry::kExact,
+            0,
+            0,
+            Move::NullMove(),
+            false),
+        tt_keys[i],
+        0,
+        false);
+  }
+
+  fmt::println("{} positions, {} legal moves, {} noisy moves",
+               boards.size(),
+               CountMoves(legal_moves),
+               CountMoves(noisy_moves));
+  // Counting the events of each kernel separately splits the cost of the
+  // search into its phases, which the bench can only report as a whole
+  perf::CounterGroup counters;
+  if (!counters.Open()) {
+    fmt::println("perf counters unavailable: {}", counters.GetError());
+  }
+  PrintHeader(counters.IsOpen());
+
+  const auto run = [&](std::string_view name, auto &&kernel) {
+    if (name.find(filter) == std::string_view::npos) return Result{};
+    const auto result = Measure(kernel, counters);
+    PrintResult(name, result);
+    return result;
+  };
+
+  run("nnue::Evaluate", [&]() -> U64 {
+    for (auto &board : boards) DoNotOptimize(nnue::Evaluate(*board));
+    return boards.size();
+  });
+
+  const auto make_undo = run("Board::MakeMove + UndoMove", [&]() -> U64 {
+    U64 ops = 0;
+    for (std::size_t i = 0; i < boards.size(); i++) {
+      for (const auto move : legal_moves[i]) {
+        boards[i]->MakeMove(move);
+        boards[i]->UndoMove();
+      }
+      ops += legal_moves[i].size();
+    }
+    return ops;
+  });
+
+  const auto make_apply_undo =
+      run("Board::MakeMove + ApplyChanges + UndoMove", [&]() -> U64 {
+        U64 ops = 0;
+        for (std::size_t i = 0; i < boards.size(); i++) {
+          for (const auto move : legal_moves[i]) {
+            boards[i]->MakeMove(move);
+            boards[i]->GetAccumulator()->ApplyChanges(boards[i]->GetState());
+            boards[i]->UndoMove();
+          }
+          ops += legal_moves[i].size();
+        }
+        return ops;
+      });
+
+  // The accumulator update can't be timed on its own since it needs a move to
+  // be made first, so it is derived from the two measurements above
+  if (make_undo.ns_per_op > 0 && make_apply_undo.ns_per_op > 0) {
+    PrintResult("Accumulator::ApplyChanges (derived)",
+                {make_apply_undo.ns_per_op - make_undo.ns_per_op,
+                 make_apply_undo.cycles_per_op - make_undo.cycles_per_op,
+                 {},
+                 1});
+  }
+
+  // Alternating between unrelated positions makes every refresh apply a large
+  // difference, which is the worst case for the bucket cache
+  run("Accumulator::RefreshPerspective", [&]() -> U64 {
+    for (auto &board : boards) {
+      for (const Color color : {Color::kWhite, Color::kBlack}) {
+        refresh_accumulator->RefreshPerspective(
+            *refresh_entry, board->GetState(), color);
+      }
+      DoNotOptimize(*refresh_entry);
+    }
+    return boards.size() * 2;
+  });
+
+  run("move_gen::BishopMoves + RookMoves", [&]() -> U64 {
+    for (auto &board : boards) {
+      const BitBoard occupied = board->GetState().Occupied();
+      for (Square square = 0; square < kSquareCount; square++) {
+        DoNotOptimize(move_gen::BishopMoves(square, occupied));
+        DoNotOptimize(move_gen::RookMoves(square, occupied));
+      }
+    }
+    return boards.size() * kSquareCount * 2;
+  });
+
+  run("move_gen::GenerateMoves<kAll>", [&]() -> U64 {
+    for (auto &board : boards) {
+      DoNotOptimize(move_gen::GenerateMoves<MoveGenType::kAll>(*board));
+    }
+    return boards.size();
+  });
+
+  run("move_gen::GenerateMoves<kNoisy>", [&]() -> U64 {
+    for (auto &board : boards) {
+      DoNotOptimize(move_gen::GenerateMoves<MoveGenType::kNoisy>(*board));
+    }
+    return boards.size();
+  });
+
+  run("move_gen::GenerateMoves<kQuiet>", [&]() -> U64 {
+    for (auto &board : boards) {
+      DoNotOptimize(move_gen::GenerateMoves<MoveGenType::kQuiet>(*board));
+    }
+    return boards.size();
+  });
+
+  run("move_gen::GenerateMoves<kLegalAll>", [&]() -> U64 {
+    for (auto &board : boards) {
+      DoNotOptimize(move_gen::GenerateMoves<MoveGenType::kLegalAll>(*board));
+    }
+    return boards.size();
+  });
+
+  run("Board::IsMoveLegal", [&]() -> U64 {
+    U64 ops = 0;
+    for (std::size_t i = 0; i < boards.size(); i++) {
+      for (const auto move : legal_moves[i]) {
+        DoNotOptimize(boards[i]->IsMoveLegal(move));
+      }
+      ops += legal_moves[i].size();
+    }
+    return ops;
+  });
+
+  run("eval::StaticExchange", [&]() -> U64 {
+    U64 ops = 0;
+    for (std::size_t i = 0; i < boards.size(); i++) {
+      const auto &state = boards[i]->GetState();
+      for (const auto move : noisy_moves[i]) {
+        DoNotOptimize(eval::StaticExchange(move, 0, state));
+      }
+      ops += noisy_moves[i].size();
+    }
+    return ops;
+  });
+
+  run("MovePicker::Next", [&]() -> U64 {
+    U64 ops = 0;
+    for (auto &board : boards) {
+      search::MovePicker picker(search::MovePickerType::kSearch,
+                                *board,
+                                Move::NullMove(),
+                                *history,
+                                &stack->Front());
+      while (true) {
+        const auto move = picker.Next();
+        DoNotOptimize(move);
+        ops++;
+        if (move.IsNull()) break;
+      }
+    }
+    return ops;
+  });
+
+  run("TranspositionTable::Probe", [&]() -> U64 {
+    for (const U64 key : tt_keys) {
+      DoNotOptimize(transposition_table.Probe(key).hit);
+    }
+    return tt_keys.size();
+  });
+
+  run("Board::HasUpcomingRepetition", [&]() -> U64 {
+    for (auto &board : repetition_boards) {
+      DoNotOptimize(board->HasUpcomingRepetition(0));
+    }
+    return repetition_boards.size();
+  });
+}
@@ -0,0 +1,123 @@
+#ifndef INTEGRAL_NETWORK_FILE_H
+#define INTEGRAL_NETWORK_FILE_H
+
+#include <array>
+#include <cstring>
+
+#include "definitions.h"
+
+namespace nnue {
+
+constexpr std::array<char, 8> kNetworkFileMagic = {
+    'I', 'N', 'T', 'G', 'R', 'L', 'N', 'N'};
+constexpr U32 kNetworkFileVersion = 1;
+
+// The network starts one page into the file, so that mapping the file keeps it
+// aligned for the kernels
+constexpr std::size_t kNetworkFileHeaderSize = 4096;
+
+// The layout of the weights as written by the preprocessor. Kernels that read
+// the weights in a different order rearrange them into a layout of their own
+constexpr U32 kGenericLayout = 0;
+
+struct NetworkFileHeader {
+  std::array<char, 8> magic;
+  U32 version;
+  U32 layout;
+  U64 architecture;
+  U64 size;
+  U64 checksum;
+};
+
+static_assert(sizeof(NetworkFileHeader) <= kNetworkFileHeaderSize);
+static_assert(kNetworkFileHeaderSize % simd::kAlignment == 0);
+
+[[nodiscard]] constexpr U64 MixChecksum(U64 hash, U64 value) {
+  return (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+}
+
+// Identifies the shape of the network, so that a file written for a different
+// architecture is rejected instead of being evaluated as garbage
+constexpr U64 kNetworkArchitecture = [] {
+  U64 hash = 0;
+  for (const U64 value : {static_cast<U64>(arch::kL1Size),
+                          static_cast<U64>(arch::kL2Size),
+                          static_cast<U64>(arch::kL3Size),
+                          static_cast<U64>(arch::kInputBucketCount),
+                          static_cast<U64>(arch::kOutputBucketCount),
+                          static_cast<U64>(arch::kFtQuantization),
+                          static_cast<U64>(arch::kL1Quantization),
+                          static_cast<U64>(sizeof(Network))}) {
+    hash = MixChecksum(hash, value);
+  }
+  return hash;
+}();
+
+// Catches networks that were truncated or corrupted on disk. The words are
+// mixed into four independent lanes, which keeps verifying a network at load
+// time to a few milliseconds
+[[nodiscard]] inline U64 NetworkChecksum(const void *data, std::size_t size) {
+  constexpr std::size_t kLanes = 4;
+  static_assert(sizeof(Network) % (kLanes * sizeof(U64)) == 0);
+
+  const auto bytes = static_cast<const char *>(data);
+  std::array<U64, kLanes> lanes = {1, 2, 3, 4};
+  for (std::size_t i = 0; i + kLanes * sizeof(U64) <= size;
+       i += kLanes * sizeof(U64)) {
+    for (std::size_t lane = 0; lane < kLanes; lane++) {
+      U64 word;
+      std::memcpy(&word, bytes + i + lane * sizeof(U64), sizeof(U64));
+      lanes[lane] = MixChecksum(lanes[lane], word);
+    }
+  }
+
+  U64 hash = size;
+  for (const U64 lane : lanes) hash = MixChecksum(hash, lane);
+  return hash;
+}
+
+[[nodiscard]] inline NetworkFileHeader MakeNetworkFileHeader(
+    const Network &network, U32 layout) {
+  return {
+      kNetworkFileMagic,
+      kNetworkFileVersion,
+      layout,
+      kNetworkArchitecture,
+      sizeof(Network),
+      NetworkChecksum(&network, sizeof(Network)),
+  };
+}
+
+// Converts a network as written by the trainer into the generic layout
+inline void ProcessNetwork(const RawNetwork &raw_network, Network &network) {
+  // Copy over arrays that don't need transposing
+  network.feature_weights = raw_network.feature_weights;
+  network.feature_biases = raw_network.feature_biases;
+
+  network.l1_biases = raw_network.l1_biases;
+  network.l2_biases = raw_network.l2_biases;
+  network.l3_weights = raw_network.l3_weights;
+  network.l3_biases = raw_network.l3_biases;
+
+  // Transpose l1_weights from [b][l2][l1] to [b][l1][l2]
+  for (std::size_t b = 0; b < arch::kOutputBucketCount; b++) {
+    for (std::size_t l1 = 0; l1 < arch::kL1Size; l1++) {
+      for (std::size_t l2 = 0; l2 < arch::kL2Size; l2++) {
+        network.l1_weights[b][l1][l2] = raw_network.l1_weights[b][l2][l1];
+      }
+    }
+  }
+
+  // Transpose l2_weights from [b][l3][l2] to [b][l2][l3]
+  for (std::size_t b = 0; b < arch::kOutputBucketCount; b++) {
+    for (std::size_t l2 = 0; l2 < arch::kL2Size; l2++) {
+      for (std::size_t l3 = 0; l3 < arch::kL3Size; l3++) {
+        network.l2_weights[b][l2][l3] = raw_network.l2_weights[b][l3][l2];
+      }
+    }
+  }
+}
+
+}  // namespace nnue
+
+#endif  // INTEGRAL_NETWORK_FILE_H
@@ -17,6 +17,7 @@
 #define BUILD_HAS_SSE41 __SSE4_1__
 #define BUILD_HAS_NEON __ARM_NEON
 #define BUILD_HAS_SIMD (BUILD_HAS_AVX512 || BUILD_HAS_AVX2)
+#define BUILD_SIMD_TARGET native
 #elif defined(BUILD_VNNI512)
 #define BUILD_HAS_BMI2 1
 #define BUILD_HAS_AVX512VNNI 1
@@ -27,6 +28,7 @@
 #define BUILD_HAS_SSE41 1
 #define BUILD_HAS_NEON 0
 #define BUILD_HAS_SIMD 1
+#define BUILD_SIMD_TARGET vnni512
 #elif defined(BUILD_AVX512)
 #define BUILD_HAS_BMI2 1
 #define BUILD_HAS_AVX512VNNI 0
@@ -37,6 +39,7 @@
 #define BUILD_HAS_SSE41 1
 #define BUILD_HAS_NEON 0
 #define BUILD_HAS_SIMD 1
+#define BUILD_SIMD_TARGET avx512
 #elif defined(BUILD_AVX2_BMI2)
 #define BUILD_HAS_BMI2 1
 #define BUILD_HAS_AVX512VNNI 0
@@ -47,6 +50,7 @@
 #define BUILD_HAS_SSE41 1
 #define BUILD_HAS_NEON 0
 #define BUILD_HAS_SIMD 1
+#define BUILD_SIMD_TARGET avx2_bmi2
 #elif defined(BUILD_AVX2)
 #define BUILD_HAS_BMI2 0
 #define BUILD_HAS_AVX512VNNI 0
@@ -57,6 +61,7 @@
 #define BUILD_HAS_SSE41 1
 #define BUILD_HAS_NEON 0
 #define BUILD_HAS_SIMD 1
+#define BUILD_SIMD_TARGET avx2
 #elif defined(BUILD_SSE41_POPCNT)
 #define BUILD_HAS_BMI2 0
 #define BUILD_HAS_AVX512VNNI 0
@@ -66,16 +71,25 @@
 #define BUILD_HAS_POPCNT 1
 #define BUILD_HAS_SSE41 1
 #define BUILD_HAS_NEON 0
+#define BUILD_SIMD_TARGET sse41
 #else
 #error No architecture specified
 #endif
 
-#if BUILD_HAS_SIMD
+#if BUILD_HAS_SIMD || BUILD_HAS_SSE41
 #include <immintrin.h>
 #endif
 
 namespace simd {
 
+// The same for every target, since the network and the accumulators are laid
+// out with it and multi-architecture builds share them between targets
+constexpr int kAlignment = 64;
+
+// Multi-architecture builds compile the helpers once for each target, so they
+// live in a namespace named after the target to keep the copies apart
+inline namespace BUILD_SIMD_TARGET {
+
 #if BUILD_HAS_AVX512
 
 using Vepi8 = __m512i;
@@ -84,7 +98,7 @@ using Vepi32 = __m512i;
 using Vepf32 = __m512;
 
 constexpr int kPackusOrder[8] = {0, 2, 4, 6, 1, 3, 5, 7};
-constexpr int kAlignment = 64;
+constexpr int kNumRegisters = 32;
 
 inline Vepi32 DpbusdEpi32(Vepi32 sum, Vepi8 first, Vepi8 second) {
   Vepi32 sum32 = _mm512_madd_epi16(_mm512_maddubs_epi16(first, second),
@@ -135,6 +149,10 @@ inline Vepi16 AddEpi16(Vepi32 v1, Vepi32 v2) {
   return _mm512_add_epi16(v1, v2);
 }
 
+inline Vepi16 SubEpi16(Vepi16 v1, Vepi16 v2) {
+  return _mm512_sub_epi16(v1, v2);
+}
+
 inline Vepi32 AddEpi32(Vepi32 v1, Vepi32 v2) {
   return _mm512_add_epi32(v1, v2);
 }
@@ -227,7 +245,7 @@ using Vepi32 = __m256i;
 using Vepf32 = __m256;
 
 constexpr int kPackusOrder[4] = {0, 2, 1, 3};
-constexpr int kAlignment = std::max<int>(8, sizeof(Vepi16));
+constexpr int kNumRegisters = 16;
 
 inline Vepi32 DpbusdEpi32(Vepi32 sum, Vepi8 first, Vepi8 second) {
   Vepi32 sum32 = _mm256_madd_epi16(_mm256_maddubs_epi16(first, second),
@@ -271,6 +289,10 @@ inline Vepi16 AddEpi16(Vepi32 v1, Vepi32 v2) {
   return _mm256_add_epi16(v1, v2);
 }
 
+inline Vepi16 SubEpi16(Vepi16 v1, Vepi16 v2) {
+  return _mm256_sub_epi16(v1, v2);
+}
+
 inline Vepi32 AddEpi32(Vepi32 v1, Vepi32 v2) {
   return _mm256_add_epi32(v1, v2);
 }
@@ -395,8 +417,30 @@ inline U8 GetNnzMask(Vepi32 x) {
       _mm256_castsi256_ps(_mm256_cmpgt_epi32(x, _mm256_setzero_si256())));
 }
 
-#else
-constexpr int kAlignment = 64;
+#elif BUILD_HAS_SSE41
+
+// Only the operations needed to update the accumulators, the rest of the
+// network is evaluated without explicit SIMD on these builds
+using Vepi16 = __m128i;
+
+constexpr int kNumRegisters = 16;
+
+inline Vepi16 LoadEpi16(const int16_t* memory_address) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(memory_address));
+}
+
+inline void StoreEpi16(void* memory_address, Vepi16 vector) {
+  _mm_store_si128(reinterpret_cast<__m128i*>(memory_address), vector);
+}
+
+inline Vepi16 AddEpi16(Vepi16 v1, Vepi16 v2) {
+  return _mm_add_epi16(v1, v2);
+}
+
+inline Vepi16 SubEpi16(Vepi16 v1, Vepi16 v2) {
+  return _mm_sub_epi16(v1, v2);
+}
+
 #endif
 
 inline float ReduceAddPsRecursive(float* sums, int length) {
@@ -406,6 +450,8 @@ inline float ReduceAddPsRecursive(float* sums, int length) {
   return ReduceAddPsRecursive(sums, length);
 }
 
+}  // namespace BUILD_SIMD_TARGET
+
 }  // namespace simd
 
 #endif  // INTEGRAL_SIMD_H_
\ No newline at end of file
@@ -19,12 +19,15 @@ constexpr std::array<U8, 64> kCastlingRights = {
 };
 // clang-format on
 
-Board::Board() : history_({}) {}
+Board::Board() : history_({}), key_history_({}) {}
 
-Board::Board(const BoardState &state) : history_({}), state_(state) {}
+Board::Board(const BoardState &state)
+    : history_({}), key_history_({}), state_(state) {}
 
 Board::Board(const Board &other)
-    : state_(other.state_), history_(other.history_) {}
+    : state_(other.state_),
+      history_(other.history_),
+      key_history_(other.key_history_) {}
 
 Board &Board::operator=(const Board &other) {
   if (this == &other) {
@@ -33,19 +36,43 @@ Board &Board::operator=(const Board &other) {
 
   state_ = other.state_;
   history_ = other.history_;
+  key_history_ = other.key_history_;
   accumulator_ = std::make_shared<nnue::Accumulator>();
   return *this;
 }
 
 void Board::SetFromFen(std::string_view fen_str) {
-  state_ = fen::StringToBoard(fen_str);
+  SetFromState(fen::StringToBoard(fen_str));
+}
 
-  accumulator_ = std::make_shared<nnue::Accumulator>();
-  accumulator_->SetFromState(state_);
+void Board::SetFromState(const BoardState &state) {
+  state_ = state;
+  state_.InvalidateThreats();
 
   history_.Clear();
+  key_history_.Clear();
 
-  CalculateThreats();
+  ResetAccumulator();
+}
+
+void Board::SetFromSnapshot(const Board &other) {
+  state_ = other.state_;
+
+  history_.Clear();
+  key_history_.Clear();
+  for (int i = 0; i < other.key_history_.Size(); i++) {
+    key_history_.Push(other.key_history_[i]);
+  }
+
+  ResetAccumulator();
+}
+
+void Board::ResetAccumulator() {
+  // The accumulator is large, so it's only allocated once per board
+  if (!accumulator_) {
+    accumulator_ = std::make_shared<nnue::Accumulator>();
+  }
+  accumulator_->SetFromState(state_);
 }
 
 bool Board::IsMovePseudoLegal(Move move) const {
@@ -82,11 +109,13 @@ bool Board::IsMovePseudoLegal(Move move) const {
     // move_gen::CastlingMoves allowing it
     const int move_dist = static_cast<int>(from) - static_cast<int>(to);
     if (move_dist == kKingsideCastleDist) {
-      return !state_.checkers && state_.castle_rights.CanKingsideCastle(us) &&
+      return !state_.InCheck() &&
+             state_.castle_rights.CanKingsideCastle(us) &&
              !(occupied & (us == Color::kWhite ? kWhiteKingsideOccupancy
                                                : kBlackKingsideOccupancy));
     } else if (move_dist == kQueensideCastleDist) {
-      return !state_.checkers && state_.castle_rights.CanQueensideCastle(us) &&
+      return !state_.InCheck() &&
+             state_.castle_rights.CanQueensideCastle(us) &&
              !(occupied & (us == Color::kWhite ? kWhiteQueensideOccupancy
                                                : kBlackQueensideOccupancy));
     }
@@ -179,31 +208,66 @@ bool Board::IsMoveLegal(Move move) const {
 
   // If the king is double-checked, it can only evade check with a king move,
   // which should've been handled earlier
-  if (state_.checkers.MoreThanOne()) {
+  const BitBoard checkers = state_.Checkers();
+  if (checkers.MoreThanOne()) {
     return false;
   }
 
   // If the piece being moved is pinned, verify that it's moving on the same
   // diagonal
-  if (state_.pinned[us].IsSet(from) &&
+  if (state_.Pinned(us).IsSet(from) &&
       !(move_gen::RayIntersecting(from, to) & king_mask)) {
     return false;
   }
 
   // If not in check, or we can take the checking piece
-  if (!state_.checkers || state_.checkers.IsSet(to)) {
+  if (!checkers || checkers.IsSet(to)) {
     return true;
   }
 
   // Only legal move left is to either take the piece that's causing check or
   // block its path
-  const auto checking_piece = state_.checkers.GetLsb();
+  const auto checking_piece = checkers.GetLsb();
   return move_gen::RayBetween(king_square, checking_piece).IsSet(to);
 }
 
-void Board::MakeMove(Move move) {
-  history_.Push(state_);
+void Board::SaveUndoRecord(Move move, PieceType captured) {
+  // The pins of the side to move carry over to the next position, where SEE
+  // uses them for the side that just moved
+  state_.UpdateKingThreats();
+
+  history_.Push({move,
+                 captured,
+                 state_.en_passant,
+                 state_.castle_rights,
+                 state_.fifty_moves_clock,
+                 state_.pawn_key,
+                 state_.minor_key,
+                 state_.major_key,
+                 state_.non_pawn_keys,
+                 state_.checkers_,
+                 state_.pinned_});
+  key_history_.Push(state_.zobrist_key);
+}
 
+void Board::RestoreUndoRecord(const UndoRecord &record) {
+  state_.turn = FlipColor(state_.turn);
+  state_.en_passant = record.en_passant;
+  state_.castle_rights = record.castle_rights;
+  state_.fifty_moves_clock = record.fifty_moves_clock;
+  state_.zobrist_key = key_history_.PopBack();
+  state_.pawn_key = record.pawn_key;
+  state_.minor_key = record.minor_key;
+  state_.major_key = record.major_key;
+  state_.non_pawn_keys = record.non_pawn_keys;
+
+  state_.checkers_ = record.checkers;
+  state_.pinned_ = record.pinned;
+  state_.king_threats_stale_ = false;
+  state_.threats_stale_ = true;
+}
+
+void Board::MakeMove(Move move) {
   const Color us = state_.turn, them = FlipColor(us);
 
   const auto from = move.GetFrom(), to = move.GetTo();
@@ -211,6 +275,8 @@ void Board::MakeMove(Move move) {
              captured = state_.GetPieceType(to);
   const auto move_type = move.GetType();
 
+  SaveUndoRecord(move, captured);
+
   // Initialize accumulator change
   nnue::AccumulatorChange accum_change{};
   accum_change.sub_0 = {from, piece, us};
@@ -274,23 +340,52 @@ void Board::MakeMove(Move move) {
   state_.fifty_moves_clock = new_fifty_move_clock;
   ++state_.half_moves;
 
-  CalculateThreats();
+  state_.InvalidateThreats();
 
   // Push the accumulator change
-  accumulator_->PushChanges(state_, accum_change);
+  accumulator_->PushChanges(accum_change);
 }
 
 void Board::UndoMove() {
-  state_ = history_.PopBack();
+  const auto &record = history_.PopBack();
+  RestoreUndoRecord(record);
+
+  const Color us = state_.turn, them = FlipColor(us);
+
+  const auto move = record.move;
+  const auto from = move.GetFrom(), to = move.GetTo();
+  const auto move_type = move.GetType();
+
+  // Move the piece back, the keys were already restored from the record
+  const auto piece = move_type == MoveType::kPromotion
+                       ? PieceType::kPawn
+                       : state_.GetPieceType(to);
+  state_.RemovePiece<false>(to, us);
+  state_.PlacePiece<false>(from, piece, us);
+
+  if (move_type == MoveType::kCastle) {
+    const Square rook_from = to > from ? Square(to + 1) : Square(to - 2);
+    const Square rook_to = to > from ? Square(to - 1) : Square(to + 1);
+    state_.RemovePiece<false>(rook_to, us);
+    state_.PlacePiece<false>(rook_from, PieceType::kRook, us);
+  } else if (move_type == MoveType::kEnPassant) {
+    const Square pawn_square = to - (us == Color::kWhite ? 8 : -8);
+    state_.PlacePiece<false>(pawn_square, PieceType::kPawn, them);
+  } else if (record.captured != PieceType::kNone) {
+    state_.PlacePiece<false>(to, record.captured, them);
+  }
+
+  --state_.half_moves;
+
   accumulator_->UndoMove();
 }
 
 void Board::UndoNullMove() {
-  state_ = history_.PopBack();
+  RestoreUndoRecord(history_.PopBack());
 }
 
 void Board::MakeNullMove() {
-  history_.Push(state_);
+  SaveUndoRecord(Move::NullMove(), PieceType::kNone);
 
   // Xor out en passant if it exists
   if (state_.en_passant != Squares::kNoSquare) {
@@ -303,7 +398,7 @@ void Board::MakeNullMove() {
 
   state_.fifty_moves_clock++;
 
-  CalculateThreats();
+  state_.InvalidateThreats();
 }
 
 U64 Board::PredictKeyAfter(Move move) const {
@@ -360,13 +455,14 @@ U64 Board::PredictKeyAfter(Move move) const {
 }
 
 bool Board::HasUpcomingRepetition(U16 ply) const {
-  const int max_dist = std::min<int>(state_.fifty_moves_clock, history_.Size());
+  const int max_dist =
+      std::min<int>(state_.fifty_moves_clock, key_history_.Size());
   if (max_dist < 3) {
     return false;
   }
 
   const auto keys_back = [this](int dist) {
-    return history_[history_.Size() - dist].zobrist_key;
+    return key_history_[key_history_.Size() - dist];
   };
 
   const auto occupied = state_.Occupied();
@@ -416,11 +512,12 @@ bool Board::IsRepetition(U16 ply) const {
     return true;
   }
 
-  const int max_dist = std::min<int>(state_.fifty_moves_clock, history_.Size());
+  const int max_dist =
+      std::min<int>(state_.fifty_moves_clock, key_history_.Size());
 
   bool hit_before_root = false;
   for (int i = 4; i <= max_dist; i += 2) {
-    if (state_.zobrist_key == history_[history_.Size() - i].zobrist_key) {
+    if (state_.zobrist_key == key_history_[key_history_.Size() - i]) {
       if (ply >= i) return true;
       if (hit_before_root) return true;
       hit_before_root = true;
@@ -491,63 +588,61 @@ void Board::HandleCastling(Move move) {
   }
 }
 
-void Board::CalculateThreats() {
-  const Color them = FlipColor(state_.turn);
+void BoardState::CalculateThreats() const {
+  const Color them = FlipColor(turn);
 
-  state_.threatened_by[kPawn] = move_gen::PawnAttacks(state_.Pawns(them), them);
+  threatened_by_[kPawn] = move_gen::PawnAttacks(Pawns(them), them);
 
-  state_.threatened_by[kKnight] = 0;
-  for (Square square : state_.Knights(them)) {
-    state_.threatened_by[kKnight] |= move_gen::KnightMoves(square);
+  threatened_by_[kKnight] = 0;
+  for (Square square : Knights(them)) {
+    threatened_by_[kKnight] |= move_gen::KnightMoves(square);
   }
 
-  const BitBoard queens = state_.Queens(them);
-  const BitBoard occupied = state_.Occupied();
+  const BitBoard queens = Queens(them);
+  const BitBoard occupied = Occupied();
 
-  state_.threatened_by[kBishop] = 0;
-  state_.threatened_by[kQueen] = 0;
-  state_.threatened_by[kRook] = 0;
+  threatened_by_[kBishop] = 0;
+  threatened_by_[kQueen] = 0;
+  threatened_by_[kRook] = 0;
 
-  for (Square square : state_.Bishops(them) | queens) {
-    state_.threatened_by[(queens.IsSet(square) ? kQueen : kBishop)] |=
+  for (Square square : Bishops(them) | queens) {
+    threatened_by_[(queens.IsSet(square) ? kQueen : kBishop)] |=
         move_gen::BishopMoves(square, occupied);
   }
 
-  for (Square square : state_.Rooks(them) | queens) {
-    state_.threatened_by[(queens.IsSet(square) ? kQueen : kRook)] |=
+  for (Square square : Rooks(them) | queens) {
+    threatened_by_[(queens.IsSet(square) ? kQueen : kRook)] |=
         move_gen::RookMoves(square, occupied);
   }
 
-  state_.threatened_by[kKing] =
-      move_gen::KingAttacks(state_.King(them).GetLsb());
+  threatened_by_[kKing] = move_gen::KingAttacks(King(them).GetLsb());
 
-  state_.threats = state_.threatened_by[kPawn] | state_.threatened_by[kKnight] |
-                   state_.threatened_by[kBishop] | state_.threatened_by[kRook] |
-                   state_.threatened_by[kQueen] | state_.threatened_by[kKing];
-
-  CalculateKingThreats();
+  threats_ = threatened_by_[kPawn] | threatened_by_[kKnight] |
+             threatened_by_[kBishop] | threatened_by_[kRook] |
+             threatened_by_[kQueen] | threatened_by_[kKing];
+  threats_stale_ = false;
 }
 
-void Board::CalculateKingThreats() {
-  const Color us = state_.turn;
+void BoardState::CalculateKingThreats() const {
+  const Color us = turn;
   const Color them = FlipColor(us);
 
-  const BitBoard our_pieces = state_.Occupied(us);
-  const BitBoard their_pieces = state_.Occupied(them);
+  const BitBoard our_pieces = Occupied(us);
+  const BitBoard their_pieces = Occupied(them);
 
-  const Square king_square = state_.King(us).GetLsb();
+  const Square king_square = King(us).GetLsb();
 
   // Calculate the pieces that are attacking the king
-  state_.checkers = (move_gen::KnightMoves(king_square) & state_.Knights()) |
-                    (move_gen::PawnAttacks(king_square, us) & state_.Pawns());
-  state_.checkers &= their_pieces;
+  checkers_ = (move_gen::KnightMoves(king_square) & Knights()) |
+              (move_gen::PawnAttacks(king_square, us) & Pawns());
+  checkers_ &= their_pieces;
 
   // Calculate our potentially pinned pieces
-  state_.pinned[us] = 0;
+  pinned_[us] = 0;
 
   // Calculate all the opponent's pieces that could reach our king
   BitBoard x_raying_pieces =
-      move_gen::GetSlidingAttackersTo(state_, king_square, their_pieces, them);
+      move_gen::GetSlidingAttackersTo(*this, king_square, their_pieces, them);
   while (x_raying_pieces) {
     const Square square = x_raying_pieces.PopLsb();
 
@@ -556,13 +651,15 @@ void Board::CalculateKingThreats() {
     const int num_blockers = pinned.PopCount();
     if (!num_blockers) {
       // This piece is directly attacking the king
-      state_.checkers |= BitBoard::FromSquare(square);
+      checkers_ |= BitBoard::FromSquare(square);
     } else if (num_blockers == 1) {
       // A piece is pinned if it's the only piece within a xray of an opponents
       // piece to our king
-      state_.pinned[us] |= pinned;
+      pinned_[us] |= pinned;
     }
   }
+
+  king_threats_stale_ = false;
 }
 
 BitBoard Board::GetOpponentWinningCaptures() const {
@@ -572,27 +669,17 @@ BitBoard Board::GetOpponentWinningCaptures() const {
   const BitBoard rooks = queens | state_.Rooks(us);
   const BitBoard minors = rooks | state_.Knights(us) | state_.Bishops(us);
 
-  const BitBoard pawn_threats = state_.threatened_by[kPawn];
-  const BitBoard minor_threats = pawn_threats | state_.threatened_by[kKnight] |
-                                 state_.threatened_by[kBishop];
-  const BitBoard rook_threats = minor_threats | state_.threatened_by[kRook];
+  const BitBoard pawn_threats = state_.ThreatenedBy(kPawn);
+  const BitBoard minor_threats = pawn_threats | state_.ThreatenedBy(kKnight) |
+                                 state_.ThreatenedBy(kBishop);
+  const BitBoard rook_threats = minor_threats | state_.ThreatenedBy(kRook);
 
   return (queens & rook_threats) | (rooks & minor_threats) |
          (minors & pawn_threats);
 }
 
 MoveList Board::GetLegalMoves() const {
-  auto move_list = move_gen::GenerateMoves<MoveGenType::kAll>(*this);
-  auto legal_move_list = MoveList{};
-
-  for (int i = 0; i < move_list.Size(); i++) {
-    const auto move = move_list[i];
-    if (IsMoveLegal(move)) {
-      legal_move_list.Push(move);
-    }
-  }
-
-  return legal_move_list;
+  return move_gen::GenerateMoves<MoveGenType::kLegalAll>(*this);
 }
 
 void Board::PrintPieces() {
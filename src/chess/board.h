@@ -94,9 +94,13 @@ struct BoardState {
         minor_key(0ULL),
         major_key(0ULL),
         non_pawn_keys({}),
-        checkers(0ULL),
-        pinned({}),
-        half_moves(0) {
+        half_moves(0),
+        checkers_(0ULL),
+        threats_(0ULL),
+        threatened_by_({}),
+        pinned_({}),
+        threats_stale_(false),
+        king_threats_stale_(false) {
     piece_on_square.fill(PieceType::kNone);
   }
 
@@ -250,8 +254,44 @@ struct BoardState {
     return piece_bbs[PieceType::kKing];
   }
 
-  [[nodiscard]] constexpr bool InCheck() const {
-    return checkers != 0;
+  [[nodiscard]] BitBoard Checkers() const {
+    UpdateKingThreats();
+    return checkers_;
+  }
+
+  [[nodiscard]] BitBoard Pinned(Color side) const {
+    UpdateKingThreats();
+    return pinned_[side];
+  }
+
+  // Squares attacked by the opponent of the side to move
+  [[nodiscard]] BitBoard Threats() const {
+    UpdateThreats();
+    return threats_;
+  }
+
+  [[nodiscard]] BitBoard ThreatenedBy(PieceType piece_type) const {
+    UpdateThreats();
+    return threatened_by_[piece_type];
+  }
+
+  [[nodiscard]] bool InCheck() const {
+    return Checkers() != 0;
+  }
+
+  // Marks the threats, checkers and pins as outdated after the position
+  // changed. They're only computed again once they're used, so nodes that are
+  // cut off early (by the TT or a stand pat for example) never pay for them
+  void InvalidateThreats() {
+    threats_stale_ = king_threats_stale_ = true;
+  }
+
+  void UpdateThreats() const {
+    if (threats_stale_) CalculateThreats();
+  }
+
+  void UpdateKingThreats() const {
+    if (king_threats_stale_) CalculateKingThreats();
   }
 
   [[nodiscard]] constexpr int MaterialCount() const {
@@ -270,9 +310,34 @@ struct BoardState {
   CastleRights castle_rights;
   U64 zobrist_key, pawn_key, minor_key, major_key;
   std::array<U64, 2> non_pawn_keys;
+
+ private:
+  friend class Board;
+
+  void CalculateThreats() const;
+
+  void CalculateKingThreats() const;
+
+  mutable BitBoard checkers_;
+  mutable BitBoard threats_;
+  mutable std::array<BitBoard, kNumPieceTypes> threatened_by_;
+  // Only the pins of the side to move are computed. Those of the other side
+  // are left over from the previous position
+  mutable std::array<BitBoard, kNumColors> pinned_;
+  mutable bool threats_stale_, king_threats_stale_;
+};
+
+// What a move changed that can't be recovered from the position after it. The
+// pieces are moved back on undo, and the threats are recomputed when needed
+struct UndoRecord {
+  Move move;
+  PieceType captured;
+  Square en_passant;
+  CastleRights castle_rights;
+  U16 fifty_moves_clock;
+  U64 pawn_key, minor_key, major_key;
+  std::array<U64, 2> non_pawn_keys;
   BitBoard checkers;
-  BitBoard threats;
-  std::array<BitBoard, kNumPieceTypes> threatened_by;
   std::array<BitBoard, kNumColors> pinned;
 };
 
@@ -296,8 +361,9 @@ class Board {
     return state_;
   }
 
-  inline auto &GetStateHistory() {
-    return history_;
+  // Pawn key of the position before the last move
+  [[nodiscard]] inline U64 GetPreviousPawnKey() const {
+    return history_.Back().pawn_key;
   }
 
   inline auto &GetAccumulator() {
@@ -306,6 +372,15 @@ class Board {
 
   void SetFromFen(std::string_view fen_str);
 
+  // Sets a position without any moves leading up to it
+  void SetFromState(const BoardState &state);
+
+  // Copies the position and the keys of the positions before it, which is all
+  // that a search from this position needs. The undo records aren't copied and
+  // this board keeps its own accumulator, which is rebuilt once the position
+  // is evaluated, so this is much cheaper than a full copy
+  void SetFromSnapshot(const Board &other);
+
   void MakeMove(Move move);
 
   void MakeNullMove();
@@ -328,10 +403,6 @@ class Board {
 
   [[nodiscard]] bool IsInsufficientMaterial() const;
 
-  void CalculateKingThreats();
-
-  void CalculateThreats();
-
   [[nodiscard]] BitBoard GetOpponentWinningCaptures() const;
 
   [[nodiscard]] MoveList GetLegalMoves() const;
@@ -339,9 +410,18 @@ class Board {
  private:
   void HandleCastling(Move move);
 
+  void SaveUndoRecord(Move move, PieceType captured);
+
+  void RestoreUndoRecord(const UndoRecord &record);
+
+  void ResetAccumulator();
+
  private:
   BoardState state_;
-  List<BoardState, 1024> history_;
+  List<UndoRecord, 1024> history_;
+  // Zobrist keys of the positions before each move, kept apart from the undo
+  // records so that repetition checks scan a dense array
+  List<U64, 1024> key_history_;
   std::shared_ptr<nnue::Accumulator> accumulator_;
 };
 
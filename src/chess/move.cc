@@ -2,10 +2,6 @@
 
 #include "board.h"
 
-Move Move::NullMove() {
-  return Move(0, 0, MoveType::kNormal);
-}
-
 Move::operator bool() const {
   return !IsNull();
 }
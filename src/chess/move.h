@@ -48,7 +48,9 @@ class Move {
     return data_ == other.data_;
   }
 
-  [[nodiscard]] static Move NullMove();
+  [[nodiscard]] static constexpr Move NullMove() {
+    return Move(0, 0, MoveType::kNormal);
+  }
 
   operator bool() const;
 
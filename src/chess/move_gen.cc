@@ -6,43 +6,6 @@
 
 namespace move_gen {
 
-constexpr std::array<BitBoard, 64> GenerateKnightMasks() {
-  std::array<BitBoard, 64> masks{};
-  for (int square = 0; square < kSquareCount; square++) {
-    const BitBoard src_mask = BitBoard::FromSquare(square);
-    masks[square] |= (src_mask & ~kFileMasks[kFileH]) << 17;
-    masks[square] |= (src_mask & ~(kFileMasks[kFileH] | kFileMasks[kFileG]))
-                  << 10;
-    masks[square] |=
-        (src_mask & ~(kFileMasks[kFileH] | kFileMasks[kFileG])) >> 6;
-    masks[square] |= (src_mask & ~kFileMasks[kFileH]) >> 15;
-    masks[square] |= (src_mask & ~kFileMasks[kFileA]) << 15;
-    masks[square] |= (src_mask & ~(kFileMasks[kFileA] | kFileMasks[kFileB]))
-                  << 6;
-    masks[square] |=
-        (src_mask & ~(kFileMasks[kFileA] | kFileMasks[kFileB])) >> 10;
-    masks[square] |= (src_mask & ~kFileMasks[kFileA]) >> 17;
-  }
-  return masks;
-}
-
-constexpr std::array<BitBoard, 64> GenerateKingMasks() {
-  std::array<BitBoard, 64> masks{};
-  for (int square = 0; square < kSquareCount; square++) {
-    const BitBoard src_mask = BitBoard::FromSquare(square);
-
-    masks[square] |= Shift<Direction::kNorth>(src_mask);
-    masks[square] |= Shift<Direction::kSouth>(src_mask);
-    masks[square] |= Shift<Direction::kEast>(src_mask);
-    masks[square] |= Shift<Direction::kWest>(src_mask);
-    masks[square] |= Shift<Direction::kNorthEast>(src_mask);
-    masks[square] |= Shift<Direction::kNorthWest>(src_mask);
-    masks[square] |= Shift<Direction::kSouthEast>(src_mask);
-    masks[square] |= Shift<Direction::kSouthWest>(src_mask);
-  }
-  return masks;
-}
-
 constexpr std::array<std::array<BitBoard, 64>, 2> GeneratePawnAttackMasks() {
   std::array<std::array<BitBoard, 64>, 2> masks{};
   for (int square = 0; square < kSquareCount; square++) {
@@ -122,12 +85,9 @@ GenerateRayIntersectingMasks() {
   return masks;
 }
 
-constexpr auto kKnightMasks = GenerateKnightMasks();
-constexpr auto kKingMasks = GenerateKingMasks();
 constexpr auto kPawnAttackMasks = GeneratePawnAttackMasks();
-// Must be const because magic attacks are initialized at runtime
-const auto kRayBetweenMasks = GenerateRayBetweenMasks();
-const auto kRayIntersectingMasks = GenerateRayIntersectingMasks();
+constexpr auto kRayBetweenMasks = GenerateRayBetweenMasks();
+constexpr auto kRayIntersectingMasks = GenerateRayIntersectingMasks();
 
 BitBoard PawnPushMoves(Square square, const BoardState &state) {
   BitBoard moves, bb_pos = BitBoard::FromSquare(square),
@@ -174,13 +134,11 @@ BitBoard KnightMoves(Square square) {
 }
 
 BitBoard BishopMoves(Square square, const BitBoard& occupied) {
-  const auto &index = magics::attacks::GetBishopAttackIndex(square, occupied);
-  return magics::attacks::kBishopAttacks[square][index];
+  return magics::attacks::GetBishopAttacks(square, occupied);
 }
 
 BitBoard RookMoves(Square square, const BitBoard& occupied) {
-  const auto &index = magics::attacks::GetRookAttackIndex(square, occupied);
-  return magics::attacks::kRookAttacks[square][index];
+  return magics::attacks::GetRookAttacks(square, occupied);
 }
 
 BitBoard QueenMoves(Square square, const BitBoard &occupied) {
@@ -191,7 +149,7 @@ BitBoard KingMoves(Square square, const BoardState &state) {
   BitBoard moves = KingAttacks(square);
 
   const auto color = state.GetPieceColor(square);
-  if (state.castle_rights.CanCastle(state.turn) && !state.checkers)
+  if (state.castle_rights.CanCastle(state.turn) && !state.InCheck())
     moves |= CastlingMoves(color, state);
 
   return moves;
@@ -290,8 +248,36 @@ void AddPromotions(Square from, Square to, MoveList &move_list) {
   move_list.Push(Move(from, to, PromotionType::kBishop));
 }
 
+// Squares that a non-king move must land on to resolve a single check, which
+// is every square when the king isn't in check
+BitBoard CheckMask(const BoardState &state) {
+  const BitBoard checkers = state.Checkers();
+  if (!checkers) return ~BitBoard(0);
+
+  const Square king_square = state.King(state.turn).GetLsb();
+  return checkers | RayBetween(king_square, checkers.GetLsb());
+}
+
+// Squares that the king can't move to. A slider checking the king also
+// attacks the squares behind it, which the threats miss since the king itself
+// blocks the ray
+BitBoard UnsafeKingSquares(const BoardState &state, Square king_square) {
+  BitBoard unsafe = state.Threats();
+
+  const BitBoard sliders = state.Bishops() | state.Rooks() | state.Queens();
+  for (Square checker : state.Checkers() & sliders) {
+    unsafe |= RayIntersecting(checker, king_square) &
+              ~BitBoard::FromSquare(checker);
+  }
+
+  return unsafe;
+}
+
 template <MoveGenType move_type>
-void AddPawnMoves(const Board &board, MoveList &move_list) {
+void AddPawnMoves(const Board &board,
+                  const BitBoard &check_mask,
+                  MoveList &move_list) {
+  constexpr bool kLegalOnly = move_type & MoveGenType::kLegal;
   auto &state = board.GetState();
 
   const BitBoard occupied = state.Occupied();
@@ -307,6 +293,32 @@ void AddPawnMoves(const Board &board, MoveList &move_list) {
                                 : 0;
 
   const BitBoard pawns = state.Pawns(state.turn);
+  const BitBoard pushable = ~occupied & check_mask;
+  const BitBoard capturable = their_pieces & check_mask;
+
+  const BitBoard pinned = state.Pinned(state.turn);
+  const Square king_square = state.King(state.turn).GetLsb();
+
+  // Pinned pawns may only move along the line through their king
+  const auto is_pin_legal = [&](Square from, Square to) {
+    return !kLegalOnly || !pinned.IsSet(from) ||
+           RayIntersecting(from, to).IsSet(king_square);
+  };
+
+  const auto add_move = [&](Square from, Square to) {
+    if (is_pin_legal(from, to)) move_list.Push(Move(from, to));
+  };
+
+  const auto add_promotions = [&](Square from, Square to) {
+    if (is_pin_legal(from, to)) AddPromotions(from, to, move_list);
+  };
+
+  const auto add_en_passant = [&](Square from, Square to) {
+    // The captured pawn leaves a square that neither the pin nor the check
+    // mask accounts for, so en passant captures are verified in full
+    const Move move(from, to, MoveType::kEnPassant);
+    if (!kLegalOnly || board.IsMoveLegal(move)) move_list.Push(move);
+  };
 
   if (state.turn == Color::kWhite) {
     const BitBoard promoting_pawns = pawns & kRankMasks[kRank7];
@@ -316,60 +328,60 @@ void AddPawnMoves(const Board &board, MoveList &move_list) {
       // Single pushes
       const BitBoard pushed_pawns =
           Shift<Direction::kNorth>(non_promoting_pawns) & ~occupied;
-      for (Square to : pushed_pawns) {
+      for (Square to : pushed_pawns & check_mask) {
         const Square from = to - 8;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
       // Double pushes
       for (Square to :
            Shift<Direction::kNorth>(pushed_pawns & kRankMasks[kRank3]) &
-               ~occupied) {
+               pushable) {
         const Square from = to - 16;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
     }
 
     if (move_type & MoveGenType::kNoisy) {
       // Push promotions
-      for (Square to : Shift<Direction::kNorth>(promoting_pawns) & ~occupied) {
+      for (Square to : Shift<Direction::kNorth>(promoting_pawns) & pushable) {
         const Square from = to - 8;
-        AddPromotions(from, to, move_list);
+        add_promotions(from, to);
       }
       // Left capture promotions
       for (Square to :
-           Shift<Direction::kNorthWest>(promoting_pawns) & their_pieces) {
+           Shift<Direction::kNorthWest>(promoting_pawns) & capturable) {
         const Square from = to - 7;
-        AddPromotions(from, to, move_list);
+        add_promotions(from, to);
       }
       // Right capture promotions
       for (Square to :
-           Shift<Direction::kNorthEast>(promoting_pawns) & their_pieces) {
+           Shift<Direction::kNorthEast>(promoting_pawns) & capturable) {
         const Square from = to - 9;
-        AddPromotions(from, to, move_list);
+        add_promotions(from, to);
       }
       // Left captures
       for (Square to :
-           Shift<Direction::kNorthWest>(non_promoting_pawns) & their_pieces) {
+           Shift<Direction::kNorthWest>(non_promoting_pawns) & capturable) {
         const Square from = to - 7;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
       // Right captures
       for (Square to :
-           Shift<Direction::kNorthEast>(non_promoting_pawns) & their_pieces) {
+           Shift<Direction::kNorthEast>(non_promoting_pawns) & capturable) {
         const Square from = to - 9;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
       // En passant captures
       if (en_passant) {
         // Left en passant
         for (Square to : Shift<Direction::kNorthWest>(pawns) & en_passant) {
           const Square from = to - 7;
-          move_list.Push(Move(from, to, MoveType::kEnPassant));
+          add_en_passant(from, to);
         }
         // Right en passant
         for (Square to : Shift<Direction::kNorthEast>(pawns) & en_passant) {
           const Square from = to - 9;
-          move_list.Push(Move(from, to, MoveType::kEnPassant));
+          add_en_passant(from, to);
         }
       }
     }
@@ -381,60 +393,60 @@ void AddPawnMoves(const Board &board, MoveList &move_list) {
       // Single pushes
       const BitBoard pushed_pawns =
           Shift<Direction::kSouth>(non_promoting_pawns) & ~occupied;
-      for (Square to : pushed_pawns) {
+      for (Square to : pushed_pawns & check_mask) {
         const Square from = to + 8;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
       // Double pushes
       for (Square to :
            Shift<Direction::kSouth>(pushed_pawns & kRankMasks[kRank6]) &
-               ~occupied) {
+               pushable) {
         const Square from = to + 16;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
     }
 
     if (move_type & MoveGenType::kNoisy) {
       // Push promotions
-      for (Square to : Shift<Direction::kSouth>(promoting_pawns) & ~occupied) {
+      for (Square to : Shift<Direction::kSouth>(promoting_pawns) & pushable) {
         const Square from = to + 8;
-        AddPromotions(from, to, move_list);
+        add_promotions(from, to);
       }
       // Left capture promotions
       for (Square to :
-           Shift<Direction::kSouthEast>(promoting_pawns) & their_pieces) {
+           Shift<Direction::kSouthEast>(promoting_pawns) & capturable) {
         const Square from = to + 7;
-        AddPromotions(from, to, move_list);
+        add_promotions(from, to);
       }
       // Right capture promotions
       for (Square to :
-           Shift<Direction::kSouthWest>(promoting_pawns) & their_pieces) {
+           Shift<Direction::kSouthWest>(promoting_pawns) & capturable) {
         const Square from = to + 9;
-        AddPromotions(from, to, move_list);
+        add_promotions(from, to);
       }
       // Left captures
       for (Square to :
-           Shift<Direction::kSouthEast>(non_promoting_pawns) & their_pieces) {
+           Shift<Direction::kSouthEast>(non_promoting_pawns) & capturable) {
         const Square from = to + 7;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
       // Right captures
       for (Square to :
-           Shift<Direction::kSouthWest>(non_promoting_pawns) & their_pieces) {
+           Shift<Direction::kSouthWest>(non_promoting_pawns) & capturable) {
         const Square from = to + 9;
-        move_list.Push(Move(from, to));
+        add_move(from, to);
       }
       // En passant captures
       if (en_passant) {
         // Left en passant
         for (Square to : Shift<Direction::kSouthWest>(pawns) & en_passant) {
           const Square from = to + 9;
-          move_list.Push(Move(from, to, MoveType::kEnPassant));
+          add_en_passant(from, to);
         }
         // Right en passant
         for (Square to : Shift<Direction::kSouthEast>(pawns) & en_passant) {
           const Square from = to + 7;
-          move_list.Push(Move(from, to, MoveType::kEnPassant));
+          add_en_passant(from, to);
         }
       }
     }
@@ -444,65 +456,87 @@ void AddPawnMoves(const Board &board, MoveList &move_list) {
 template MoveList GenerateMoves<MoveGenType::kAll>(const Board &board);
 template MoveList GenerateMoves<MoveGenType::kQuiet>(const Board &board);
 template MoveList GenerateMoves<MoveGenType::kNoisy>(const Board &board);
+template MoveList GenerateMoves<MoveGenType::kLegalAll>(const Board &board);
+template MoveList GenerateMoves<MoveGenType::kLegalQuiet>(const Board &board);
+template MoveList GenerateMoves<MoveGenType::kLegalNoisy>(const Board &board);
 
 template <MoveGenType move_type>
 MoveList GenerateMoves(const Board &board) {
+  constexpr bool kLegalOnly = move_type & MoveGenType::kLegal;
+
   MoveList move_list;
   const auto &state = board.GetState();
 
   const BitBoard occupied = state.Occupied();
   const BitBoard &their_pieces = state.Occupied(FlipColor(state.turn));
+  const Square king_square = state.King(state.turn).GetLsb();
 
   BitBoard targets = 0;
   if constexpr (move_type & MoveGenType::kQuiet) targets |= ~occupied;
   if constexpr (move_type & MoveGenType::kNoisy) targets |= their_pieces;
 
-  if (state.checkers.MoreThanOne()) {
-    // Only king moves are legal if there's multiple pieces checking the king
-    const Square king_square = state.King(state.turn).GetLsb();
-    for (Square to : KingMoves(king_square, state) & targets) {
+  const auto add_king_moves = [&]() {
+    BitBoard unsafe;
+    if constexpr (kLegalOnly) unsafe = UnsafeKingSquares(state, king_square);
+
+    for (Square to : KingMoves(king_square, state) & targets & ~unsafe) {
       const bool is_castle = std::abs(to.File() - king_square.File()) == 2;
+      // The king can't castle through an attacked square either
+      if (kLegalOnly && is_castle && unsafe.IsSet((king_square + to) / 2)) {
+        continue;
+      }
       move_list.Push(Move(
           king_square, to, is_castle ? MoveType::kCastle : MoveType::kNormal));
     }
+  };
+
+  if (state.Checkers().MoreThanOne()) {
+    // Only king moves are legal if there's multiple pieces checking the king
+    add_king_moves();
     return move_list;
   }
 
-  AddPawnMoves<move_type>(board, move_list);
+  const BitBoard check_mask = kLegalOnly ? CheckMask(state) : ~BitBoard(0);
+  AddPawnMoves<move_type>(board, check_mask, move_list);
+
+  const BitBoard pinned = state.Pinned(state.turn);
+  const auto piece_targets = [&](Square from, BitBoard moves) {
+    moves &= targets & check_mask;
+    // Pinned pieces may only move along the line through their king
+    if (kLegalOnly && pinned.IsSet(from)) {
+      moves &= RayIntersecting(from, king_square);
+    }
+    return moves;
+  };
 
   // Other piece moves
-  for (Square from : state.Knights(state.turn) & ~state.pinned[state.turn]) {
-    for (Square to : KnightMoves(from) & targets) {
+  for (Square from : state.Knights(state.turn) & ~pinned) {
+    for (Square to : piece_targets(from, KnightMoves(from))) {
       move_list.Push(Move(from, to));
     }
   }
 
   for (Square from : state.Bishops(state.turn)) {
-    for (Square to : BishopMoves(from, occupied) & targets) {
+    for (Square to : piece_targets(from, BishopMoves(from, occupied))) {
       move_list.Push(Move(from, to));
     }
   }
 
   for (Square from : state.Rooks(state.turn)) {
-    for (Square to : RookMoves(from, occupied) & targets) {
+    for (Square to : piece_targets(from, RookMoves(from, occupied))) {
       move_list.Push(Move(from, to));
     }
   }
 
   for (Square from : state.Queens(state.turn)) {
-    for (Square to : QueenMoves(from, occupied) & targets) {
+    for (Square to : piece_targets(from, QueenMoves(from, occupied))) {
       move_list.Push(Move(from, to));
     }
   }
 
-  const Square king_square = state.King(state.turn).GetLsb();
-  for (Square to : KingMoves(king_square, state) & targets) {
-    const bool is_castle = std::abs(to.File() - king_square.File()) == 2;
-    move_list.Push(Move(
-        king_square, to, is_castle ? MoveType::kCastle : MoveType::kNormal));
-  }
+  add_king_moves();
 
   return move_list;
 }
 
-}  // namespace move_gen
\ No newline at end of file
+}  // namespace move_gen
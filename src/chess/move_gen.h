@@ -7,6 +7,48 @@
 
 namespace move_gen {
 
+constexpr std::array<BitBoard, 64> GenerateKnightMasks() {
+  std::array<BitBoard, 64> masks{};
+  for (int square = 0; square < kSquareCount; square++) {
+    const BitBoard src_mask = BitBoard::FromSquare(square);
+    masks[square] |= (src_mask & ~kFileMasks[kFileH]) << 17;
+    masks[square] |= (src_mask & ~(kFileMasks[kFileH] | kFileMasks[kFileG]))
+                  << 10;
+    masks[square] |=
+        (src_mask & ~(kFileMasks[kFileH] | kFileMasks[kFileG])) >> 6;
+    masks[square] |= (src_mask & ~kFileMasks[kFileH]) >> 15;
+    masks[square] |= (src_mask & ~kFileMasks[kFileA]) << 15;
+    masks[square] |= (src_mask & ~(kFileMasks[kFileA] | kFileMasks[kFileB]))
+                  << 6;
+    masks[square] |=
+        (src_mask & ~(kFileMasks[kFileA] | kFileMasks[kFileB])) >> 10;
+    masks[square] |= (src_mask & ~kFileMasks[kFileA]) >> 17;
+  }
+  return masks;
+}
+
+constexpr std::array<BitBoard, 64> GenerateKingMasks() {
+  std::array<BitBoard, 64> masks{};
+  for (int square = 0; square < kSquareCount; square++) {
+    const BitBoard src_mask = BitBoard::FromSquare(square);
+
+    masks[square] |= Shift<Direction::kNorth>(src_mask);
+    masks[square] |= Shift<Direction::kSouth>(src_mask);
+    masks[square] |= Shift<Direction::kEast>(src_mask);
+    masks[square] |= Shift<Direction::kWest>(src_mask);
+    masks[square] |= Shift<Direction::kNorthEast>(src_mask);
+    masks[square] |= Shift<Direction::kNorthWest>(src_mask);
+    masks[square] |= Shift<Direction::kSouthEast>(src_mask);
+    masks[square] |= Shift<Direction::kSouthWest>(src_mask);
+  }
+  return masks;
+}
+
+// Attacks of knights and kings, which don't depend on the occupancy. These are
+// available at compile time for the tables that are built from them
+inline constexpr auto kKnightMasks = GenerateKnightMasks();
+inline constexpr auto kKingMasks = GenerateKingMasks();
+
 bool IsSquareAttacked(Square square, Color attacker, const BoardState &state);
 
 BitBoard PawnAttacks(BitBoard pawns, Color side);
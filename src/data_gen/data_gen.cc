@@ -8,6 +8,7 @@
 #include <fstream>
 
 #include "../chess/board.h"
+#include "../engine/evaluation/nnue/nnue.h"
 #include "../engine/search/search.h"
 #include "format/binpack.h"
 #include "format/fens.h"
@@ -366,6 +367,8 @@ void Generate(Config config) {
 
     threads.emplace_back(
         [&config, thread_path = std::move(thread_path), i, &fens]() {
+          nnue::UseNetwork();
+
           std::ofstream output_stream(thread_path,
                                       std::ios::binary | std::ios::app);
           if (!output_stream) {
@@ -11,7 +11,7 @@ class FenFormatter : public OutputFormatter {
       : output_stream_(output_stream) {}
 
   void SetPosition(const BoardState& state) override {
-    start_pos_ = Board(state);
+    start_pos_.SetFromState(state);
     fens_.clear();
   }
 
@@ -84,8 +84,8 @@ bool StaticExchange(Move move, int threshold, const BoardState &state) {
   Color turn = state.turn;
   Color winner = state.turn;
   
-  const auto white_pinned = state.pinned[Color::kWhite] & state.Occupied(Color::kWhite);
-  const auto black_pinned = state.pinned[Color::kBlack] & state.Occupied(Color::kBlack);
+  const auto white_pinned = state.Pinned(Color::kWhite) & state.Occupied(Color::kWhite);
+  const auto black_pinned = state.Pinned(Color::kBlack) & state.Occupied(Color::kBlack);
   
   const auto white_king_ray = move_gen::RayIntersecting(to, state.King(Color::kWhite).GetLsb());
   const auto black_king_ray = move_gen::RayIntersecting(to, state.King(Color::kBlack).GetLsb());
@@ -102,7 +102,7 @@ bool StaticExchange(Move move, int threshold, const BoardState &state) {
     all_attackers &= occupied;
 
     BitBoard our_attackers = all_attackers & state.Occupied(turn);
-    if ((state.pinned[turn] & occupied)) {
+    if ((state.Pinned(turn) & occupied)) {
       our_attackers &= ~pinned | pinned_aligned;
     }
 
@@ -5,6 +5,7 @@
 #include "../../../../shared/simd.h"
 #include "../../../chess/board.h"
 #include "../../../utils/fused.h"
+#include "kernels/kernels.h"
 #include "nnue.h"
 
 namespace nnue {
@@ -41,11 +42,12 @@ struct AccumulatorChange {
   } type;
 };
 
-static std::array<I16, arch::kL1Size>& GetFeatureTable(Square square,
-                                                       Square king_square,
-                                                       PieceType piece,
-                                                       Color piece_color,
-                                                       Color perspective) {
+static const std::array<I16, arch::kL1Size>& GetFeatureTable(
+    Square square,
+    Square king_square,
+    PieceType piece,
+    Color piece_color,
+    Color perspective) {
   if (king_square.File() >= kFileE) {
     square = square ^ 0b111;
   }
@@ -122,15 +124,25 @@ class PerspectiveAccumulator {
                                perspective);
     };
 
-    const std::tuple changes = {FeatureTable(accumulator_changes)...};
-
-    for (int i = 0; i < arch::kL1Size; ++i) {
-      values_[i] = std::apply(
-          [&](const auto&... changes) {
-            return Fused<ops...>(previous[i], changes[i]...);
-          },
-          changes);
-    }
+    std::array<I16 const*, sizeof...(ops)> adds, subs;
+    int num_adds = 0, num_subs = 0;
+    (
+        [&](FusedOperation op, const FeatureData& feature) {
+          if (op == kAdd) {
+            adds[num_adds++] = FeatureTable(feature);
+          } else {
+            subs[num_subs++] = FeatureTable(feature);
+          }
+        }(ops, accumulator_changes),
+        ...);
+
+    kernels::kKernels.update_accumulator(previous.Data(),
+                                         Data(),
+                                         nullptr,
+                                         adds.data(),
+                                         num_adds,
+                                         subs.data(),
+                                         num_subs);
   }
 
   void ApplyChange(const PerspectiveAccumulator& previous,
@@ -162,6 +174,14 @@ class PerspectiveAccumulator {
     }
   }
 
+  [[nodiscard]] I16* Data() {
+    return values_.data();
+  }
+
+  [[nodiscard]] const I16* Data() const {
+    return values_.data();
+  }
+
   I16& operator[](int idx) {
     return values_[idx];
   }
@@ -179,7 +199,6 @@ struct AccumulatorEntry {
   AccumulatorChange change;
   std::array<Square, 2> kings;
   std::array<bool, 2> updated;
-  BoardState state;
 };
 
 struct BucketCacheEntry {
@@ -205,14 +224,19 @@ class Accumulator {
     stack_.resize(512);
   }
 
+  // Starts the accumulator over from a new position. Nothing is computed until
+  // the next ApplyChanges(), which refreshes the position from empty bucket
+  // caches, so setting up a position that is never evaluated costs nothing
   void SetFromState(const BoardState& state) {
     head_idx_ = 0;
+    root_state_ = state;
+    auto& accumulator = stack_[head_idx_];
     for (const Color color : {Color::kBlack, Color::kWhite}) {
-      auto& accumulator = stack_[head_idx_];
-      RefreshPerspective(accumulator, state, color, true);
-      accumulator.updated[color] = true;
+      accumulator.updated[color] = false;
       accumulator.kings[color] = state.King(color).GetLsb();
     }
+    needs_rebuild_ = true;
+    refreshes_ = 0;
   }
 
   void RefreshPerspective(AccumulatorEntry& __restrict__ accumulator,
@@ -269,49 +293,28 @@ class Accumulator {
       }
     }
 
-    // Perform all add operations
-    for (; num_adds >= 4; num_adds -= 4) {
-      for (int i = 0; i < arch::kL1Size; ++i) {
-        perspective_accumulator[i] +=
-            adds[num_adds - 4][i] + adds[num_adds - 3][i] +
-            adds[num_adds - 2][i] + adds[num_adds - 1][i];
-      }
-    }
-    for (; num_adds >= 1; num_adds -= 1) {
-      for (int i = 0; i < arch::kL1Size; ++i) {
-        perspective_accumulator[i] += adds[num_adds - 1][i];
-      }
-    }
-
-    // Perform all sub operations
-    for (; num_subs >= 4; num_subs -= 4) {
-      for (int i = 0; i < arch::kL1Size; ++i) {
-        perspective_accumulator[i] -=
-            subs[num_subs - 4][i] + subs[num_subs - 3][i] +
-            subs[num_subs - 2][i] + subs[num_subs - 1][i];
-      }
-    }
-    for (; num_subs >= 1; num_subs -= 1) {
-      for (int i = 0; i < arch::kL1Size; ++i) {
-        perspective_accumulator[i] -= subs[num_subs - 1][i];
-      }
-    }
+    // Apply the whole difference in a single pass over the cached accumulator,
+    // which also writes the result to the accumulator being refreshed
+    kernels::kKernels.update_accumulator(
+        perspective_accumulator.Data(),
+        perspective_accumulator.Data(),
+        accumulator.perspectives[perspective].Data(),
+        adds.data(),
+        num_adds,
+        subs.data(),
+        num_subs);
 
     cached.side_bbs[perspective] = state.side_bbs;
     cached.piece_bbs[perspective] = state.piece_bbs;
-
-    accumulator.perspectives[perspective] =
-        cached.accumulator.perspectives[perspective];
   }
 
-  void PushChanges(const BoardState& state, AccumulatorChange& change) {
+  void PushChanges(const AccumulatorChange& change) {
     IncrementHead();
 
     auto& entry = stack_[head_idx_];
     entry.change = change;
     entry.updated[Color::kBlack] = false;
     entry.updated[Color::kWhite] = false;
-    entry.state = state;
 
     // Update king positions if necessary
     if (change.sub_0.piece == PieceType::kKing) {
@@ -326,45 +329,56 @@ class Accumulator {
         stack_[head_idx_ - 1].kings[FlipColor(change.sub_0.color)];
   }
 
-  void ApplyChanges() {
+  // Brings the accumulator of the current position, whose board state is
+  // given, up to date. A perspective is updated incrementally from the last
+  // position it was computed in, unless its king changed buckets since then.
+  // The stack only keeps the changes between positions, so in that case just
+  // the current position is refreshed, and the ones in between are left for a
+  // later update if they're ever needed
+  void ApplyChanges(const BoardState& state) {
+    if (needs_rebuild_) {
+      Rebuild();
+    }
+
+    auto& head = stack_[head_idx_];
     for (Color perspective : {Color::kWhite, Color::kBlack}) {
-      if (stack_[head_idx_].updated[perspective]) {
+      if (head.updated[perspective]) {
         continue;
       }
 
-      int iter = head_idx_;
-      while (true) {
-        --iter;
-
-        // We've found the earliest updated accumulator
-        if (stack_[iter].updated[perspective]) {
-          int last_updated = iter;
-
-          // Apply all updates from the earliest updated accumulator to now
-          while (last_updated != head_idx_) {
-            auto& dirty_accumulator = stack_[last_updated + 1];
-            const auto& clean_accumulator = stack_[last_updated];
-
-            // If the accumulator needs a refresh, we skip applying updates and
-            // just refresh it
-            if (NeedRefresh(perspective,
-                            clean_accumulator.kings[perspective],
-                            dirty_accumulator.kings[perspective])) {
-              RefreshPerspective(
-                  dirty_accumulator, dirty_accumulator.state, perspective);
-            } else {
-              dirty_accumulator.perspectives[perspective].ApplyChange(
-                  clean_accumulator.perspectives[perspective],
-                  dirty_accumulator.change,
-                  perspective,
-                  dirty_accumulator.kings[perspective]);
-            }
-            // Mark the accumulator as having been updated
-            stack_[++last_updated].updated[perspective] = true;
-          }
+      // Find the latest updated accumulator, stopping early if the king moved
+      // into another bucket on the way
+      int last_updated = head_idx_;
+      bool king_moved_bucket = false;
+      while (!stack_[last_updated].updated[perspective]) {
+        if (NeedRefresh(perspective,
+                        stack_[last_updated - 1].kings[perspective],
+                        stack_[last_updated].kings[perspective])) {
+          king_moved_bucket = true;
           break;
         }
+        --last_updated;
+      }
+
+      if (king_moved_bucket) {
+        RefreshPerspective(head, state, perspective);
+        refreshes_++;
+      } else {
+        // Apply all updates from the latest updated accumulator to now
+        while (last_updated != head_idx_) {
+          auto& dirty_accumulator = stack_[last_updated + 1];
+          const auto& clean_accumulator = stack_[last_updated];
+          dirty_accumulator.perspectives[perspective].ApplyChange(
+              clean_accumulator.perspectives[perspective],
+              dirty_accumulator.change,
+              perspective,
+              dirty_accumulator.kings[perspective]);
+          // Mark the accumulator as having been updated
+          stack_[++last_updated].updated[perspective] = true;
+        }
       }
+
+      head.updated[perspective] = true;
     }
   }
 
@@ -392,6 +406,12 @@ class Accumulator {
     --head_idx_;
   }
 
+  // Number of times a perspective had to be refreshed because its king moved
+  // into a different bucket since the position was last set
+  [[nodiscard]] U64 GetRefreshCount() const {
+    return refreshes_;
+  }
+
   [[nodiscard]] int GetOutputBucket(const BoardState& state) const {
     return std::min((state.Occupied().PopCount() - 2) / kBucketDivisor,
                     static_cast<int>(arch::kOutputBucketCount - 1));
@@ -407,6 +427,24 @@ class Accumulator {
   }
 
  private:
+  // Resets the bucket caches and refreshes the position that the accumulator
+  // was last set to
+  void Rebuild() {
+    for (auto& bucket_caches : input_bucket_cache_) {
+      for (auto& cached : bucket_caches) {
+        cached.Reset();
+      }
+    }
+
+    auto& accumulator = stack_[0];
+    for (const Color color : {Color::kBlack, Color::kWhite}) {
+      RefreshPerspective(accumulator, root_state_, color);
+      accumulator.updated[color] = true;
+    }
+
+    needs_rebuild_ = false;
+  }
+
   [[nodiscard]] inline int GetKingBucket(Square king_square,
                                          Color king_color) const {
     return kKingBucketMap[king_square ^ (56 * king_color)];
@@ -414,6 +452,11 @@ class Accumulator {
 
  private:
   int head_idx_;
+  bool needs_rebuild_ = false;
+  // The position that the accumulator was last set to, which the first entry
+  // of the stack is computed from
+  BoardState root_state_;
+  U64 refreshes_ = 0;
   std::vector<AccumulatorEntry> stack_;
   MultiArray<BucketCacheEntry, 2, arch::kInputBucketCount> input_bucket_cache_;
 };
@@ -0,0 +1,5 @@
+// The kernels for CPUs with AVX2, which multi-architecture builds compile
+// with the flags of that target (see CMakeLists.txt)
+#if defined(BUILD_MULTIARCH)
+#include "kernels_impl.h"
+#endif
@@ -0,0 +1,23 @@
+#include "kernels.h"
+
+#include "../../../../utils/cpu.h"
+#include "kernels_impl.h"
+
+namespace nnue::kernels {
+
+namespace {
+
+[[nodiscard]] const KernelSet &SelectKernels() {
+#if defined(BUILD_MULTIARCH)
+  if (cpu::HasAvx512Vnni()) return vnni512::kKernelSet;
+  if (cpu::HasAvx512()) return avx512::kKernelSet;
+  if (cpu::HasAvx2()) return avx2::kKernelSet;
+#endif
+  return BUILD_SIMD_TARGET::kKernelSet;
+}
+
+}  // namespace
+
+const KernelSet &kKernels = SelectKernels();
+
+}  // namespace nnue::kernels
@@ -0,0 +1,68 @@
+#ifndef INTEGRAL_NNUE_KERNELS_H
+#define INTEGRAL_NNUE_KERNELS_H
+
+#include "../../../../../shared/nnue/definitions.h"
+#include "../../../../../shared/simd.h"
+#include "../../../../utils/types.h"
+
+namespace nnue::kernels {
+
+// The code of the network that depends on the SIMD target. Multi-architecture
+// builds carry a set of kernels for every target they support and pick the
+// best one that the CPU can run at startup (see CMakeLists.txt)
+struct KernelSet {
+  // Name of the target that the kernels were compiled for
+  const char *name;
+
+  // Copies a network in the layout written by the preprocessor into the one
+  // that these kernels read, or null if they read it as it is
+  void (*prepare_network)(const Network &source, Network &network);
+
+  // Identifies the layout that the kernels read in network files, which is
+  // the generic one if they don't prepare the network
+  U32 network_layout;
+
+  // Computes output = input + the add rows - the sub rows over an accumulator,
+  // and writes it to copy as well if given. The input may be the output
+  void (*update_accumulator)(const I16 *input,
+                             I16 *output,
+                             I16 *copy,
+                             const I16 *const *adds,
+                             int num_adds,
+                             const I16 *const *subs,
+                             int num_subs);
+
+  // Evaluates the network from the accumulators of the side to move and of
+  // the other side
+  Score (*forward)(const I16 *us,
+                   const I16 *them,
+                   const Network &network,
+                   int bucket);
+};
+
+// Every build has the kernels of the target that it's compiled for, which are
+// the fallback of multi-architecture builds
+namespace BUILD_SIMD_TARGET {
+extern const KernelSet kKernelSet;
+}
+
+#if defined(BUILD_MULTIARCH)
+namespace avx2 {
+extern const KernelSet kKernelSet;
+}
+
+namespace avx512 {
+extern const KernelSet kKernelSet;
+}
+
+namespace vnni512 {
+extern const KernelSet kKernelSet;
+}
+#endif
+
+// The kernels picked for the CPU that the engine runs on
+extern const KernelSet &kKernels;
+
+}  // namespace nnue::kernels
+
+#endif  // INTEGRAL_NNUE_KERNELS_H
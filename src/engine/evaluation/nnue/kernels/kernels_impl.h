@@ -0,0 +1,444 @@
+#ifndef INTEGRAL_NNUE_KERNELS_IMPL_H
+#define INTEGRAL_NNUE_KERNELS_IMPL_H
+
+// The kernels of the network, compiled for the target of the translation unit
+// that includes this file. Everything defined here either has internal linkage
+// or lives in the namespace of the target, so that the copies of different
+// targets in a multi-architecture build never get mixed up by the linker
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#include "../../../../../shared/nnue/definitions.h"
+#include "../../../../../shared/nnue/network_file.h"
+#include "../../../../../shared/simd.h"
+#include "../nnz_table.h"
+#include "kernels.h"
+
+#ifdef SPARSE_PERMUTE
+#include "../sparse.h"
+#endif
+
+#define INTEGRAL_KERNELS_STRINGIFY(target) #target
+#define INTEGRAL_KERNELS_NAME(target) INTEGRAL_KERNELS_STRINGIFY(target)
+
+namespace nnue::kernels {
+
+namespace {
+
+#if BUILD_HAS_SIMD || BUILD_HAS_SSE41
+constexpr int kLanesPerRegister = sizeof(simd::Vepi16) / sizeof(I16);
+// Half of the registers hold the tile while the rest are left for the rows
+// that are loaded into it
+constexpr int kTileRegisters = simd::kNumRegisters / 2;
+constexpr int kTileSize = kTileRegisters * kLanesPerRegister;
+static_assert(arch::kL1Size % kTileSize == 0);
+#endif
+
+// Each tile of the accumulator is loaded into registers once, has every row
+// applied to it and is stored once, so that the cost of an update doesn't grow
+// with a pass over the accumulator per row
+void UpdateAccumulator(const I16 *input,
+                       I16 *output,
+                       I16 *copy,
+                       const I16 *const *adds,
+                       int num_adds,
+                       const I16 *const *subs,
+                       int num_subs) {
+#if BUILD_HAS_SIMD || BUILD_HAS_SSE41
+  for (int tile = 0; tile < arch::kL1Size; tile += kTileSize) {
+    simd::Vepi16 registers[kTileRegisters];
+    for (int i = 0; i < kTileRegisters; ++i) {
+      registers[i] = simd::LoadEpi16(&input[tile + i * kLanesPerRegister]);
+    }
+
+    for (int row = 0; row < num_adds; ++row) {
+      const I16 *weights = &adds[row][tile];
+      for (int i = 0; i < kTileRegisters; ++i) {
+        registers[i] = simd::AddEpi16(
+            registers[i], simd::LoadEpi16(&weights[i * kLanesPerRegister]));
+      }
+    }
+
+    for (int row = 0; row < num_subs; ++row) {
+      const I16 *weights = &subs[row][tile];
+      for (int i = 0; i < kTileRegisters; ++i) {
+        registers[i] = simd::SubEpi16(
+            registers[i], simd::LoadEpi16(&weights[i * kLanesPerRegister]));
+      }
+    }
+
+    for (int i = 0; i < kTileRegisters; ++i) {
+      simd::StoreEpi16(&output[tile + i * kLanesPerRegister], registers[i]);
+    }
+    if (copy) {
+      for (int i = 0; i < kTileRegisters; ++i) {
+        simd::StoreEpi16(&copy[tile + i * kLanesPerRegister], registers[i]);
+      }
+    }
+  }
+#else
+  if (input != output) {
+    std::copy(input, input + arch::kL1Size, output);
+  }
+  for (int row = 0; row < num_adds; ++row) {
+    for (int i = 0; i < arch::kL1Size; ++i) output[i] += adds[row][i];
+  }
+  for (int row = 0; row < num_subs; ++row) {
+    for (int i = 0; i < arch::kL1Size; ++i) output[i] -= subs[row][i];
+  }
+  if (copy) {
+    std::copy(output, output + arch::kL1Size, copy);
+  }
+#endif
+}
+
+#if BUILD_HAS_SIMD and !defined(SPARSE_PERMUTE)
+
+void PrepareNetwork(const Network &source, Network &network) {
+  // Packing the activated features interleaves the 128-bit blocks of the two
+  // vectors that are packed, so the feature weights and biases are stored in
+  // an order that undoes it
+  constexpr int kNumRegs = sizeof(simd::Vepi16) / 8;
+
+  const auto permute_blocks = [](const auto &from, auto &to) {
+    static_assert(sizeof(from) % (kNumRegs * sizeof(__m128i)) == 0);
+    const auto from_blocks = reinterpret_cast<const __m128i *>(&from);
+    auto to_blocks = reinterpret_cast<__m128i *>(&to);
+    for (std::size_t i = 0; i < sizeof(from) / sizeof(__m128i); i += kNumRegs) {
+      for (int j = 0; j < kNumRegs; j++) {
+        to_blocks[i + j] = from_blocks[i + simd::kPackusOrder[j]];
+      }
+    }
+  };
+  permute_blocks(source.feature_weights, network.feature_weights);
+  permute_blocks(source.feature_biases, network.feature_biases);
+
+  // Weight permutation for DpbusdEpi32
+  for (int bucket = 0; bucket < arch::kOutputBucketCount; bucket++) {
+    for (int i = 0; i < arch::kL1Size; i += 4) {
+      for (int j = 0; j < arch::kL2Size; ++j) {
+        for (int k = 0; k < 4; k++) {
+          network.l1_weights_alt[bucket][i * arch::kL2Size + j * 4 + k] =
+              source.l1_weights[bucket][i + k][j];
+        }
+      }
+    }
+  }
+
+  network.l1_biases = source.l1_biases;
+  network.l2_weights = source.l2_weights;
+  network.l2_biases = source.l2_biases;
+  network.l3_weights = source.l3_weights;
+  network.l3_biases = source.l3_biases;
+}
+
+Score Forward(const I16 *us,
+              const I16 *them,
+              const Network &network,
+              int bucket) {
+  constexpr int kFtShift = 9;
+
+  constexpr int kI32ChunkSize = sizeof(simd::Vepi16) / sizeof(I32);
+  constexpr int kI16ChunkSize = sizeof(simd::Vepi16) / sizeof(I16);
+  constexpr int kI8ChunkSize = sizeof(simd::Vepi16) / sizeof(I8);
+  constexpr int kF32ChunkSize = sizeof(simd::Vepi16) / sizeof(float);
+
+  const auto quantise_vector = simd::SetEpi16(arch::kFtQuantization);
+
+  std::array<U16, arch::kL1Size / 4> nnz_indices{};
+  int nnz_count = 0;
+  auto nnz_base = _mm_setzero_si128();
+  const auto lookup_increment = _mm_set1_epi16(8);
+
+  // Activate the feature layer neurons
+  alignas(simd::kAlignment) std::array<U8, arch::kL1Size> feature_output{};
+  for (int side = 0; side <= 1; side++) {
+    const I16 *stm_accumulator = side == 0 ? us : them;
+    for (int i = 0; i < arch::kL1Size / 2; i += kI8ChunkSize) {
+      // Clip first accumulator values
+      const auto accumulator_value = simd::LoadEpi16(&stm_accumulator[i]);
+      const auto pair_accumulator_value =
+          simd::LoadEpi16(&stm_accumulator[i + arch::kL1Size / 2]);
+      const auto clipped_value =
+          simd::Clip(accumulator_value, arch::kFtQuantization);
+      const auto clipped_pair_value =
+          simd::Min(pair_accumulator_value, quantise_vector);
+
+      // Clip second accumulator values
+      const auto accumulator_value1 =
+          simd::LoadEpi16(&stm_accumulator[i + kI16ChunkSize]);
+      const auto pair_accumulator_value1 = simd::LoadEpi16(
+          &stm_accumulator[i + arch::kL1Size / 2 + kI16ChunkSize]);
+      const auto clipped_value1 =
+          simd::Clip(accumulator_value1, arch::kFtQuantization);
+      const auto clipped_pair_value1 =
+          simd::Min(pair_accumulator_value1, quantise_vector);
+
+      // Perform a left-shift on them and multiply the products using the
+      // higher 16 bits
+      const auto first_product = simd::MulhiEpi16(
+          simd::SlliEpi16(clipped_value, 16 - kFtShift), clipped_pair_value);
+      const auto second_product = simd::MulhiEpi16(
+          simd::SlliEpi16(clipped_value1, 16 - kFtShift), clipped_pair_value1);
+
+      // Pack the two I16 vectors into an I8 vector, which will clamp negative
+      // values to 0 because of unsigned saturation. This is why we didn't clamp
+      // the pair values to 0 earlier, effectively saving us an operation
+      auto &features = *reinterpret_cast<simd::Vepi8 *>(
+          &feature_output[i + side * arch::kL1Size / 2]);
+      features = simd::PackusEpi16(first_product, second_product);
+
+      // Sparse Processing, or NNZ (Number of Non-Zero), is an optimization we
+      // perform to minimize the amount of computation done by only mat-mulling
+      // the positive, non-zero activated features with the next layer's weights
+      // -----------------------------------------------------------------------
+      // Get a mask of all positive, non-zero elements
+      // Each bit in `nnz_mask` corresponds to whether a specific feature is
+      // positive (1) or zero (0)
+      const auto nnz_mask = simd::GetNnzMask(features);
+      // Loop through 8-bit (U8) slices of this 16-bit mask
+      for (int chunk = 0; chunk < kI32ChunkSize; chunk += 8) {
+        // Extract the 8-bit slice from the mask
+        const U8 slice = (nnz_mask >> chunk) & 0xFF;
+        // Lookup the relative indices for each set bit in the mask, essentially
+        // retrieving the indices for each positive element as an 8-element
+        // vector of I16s
+        const auto indices = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+            &sparse::nnz_table[slice].indices));
+        // Store these absolute indices into our table. We account for the fact
+        // that they are relative indices (to this slice) by adding `nnz_base`,
+        // which will reflect the position each element is in the entire table
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&nnz_indices[nnz_count]),
+                         _mm_add_epi16(nnz_base, indices));
+        // Update to reflect the total number of non-zero features processed
+        nnz_count += std::popcount(slice);
+        // Increment to reflect the starting index of the next slice
+        nnz_base = _mm_add_epi16(nnz_base, lookup_increment);
+      }
+    }
+  }
+
+  // Forward the feature layer neurons to the 2nd layer
+  alignas(simd::kAlignment) std::array<I32, arch::kL2Size> l1_sums{};
+  {
+    int i = 0;
+    for (; i < nnz_count - 1; i += 2) {
+      const int idx = nnz_indices[i] * 4, idx_two = nnz_indices[i + 1] * 4;
+      const auto feature_vector =
+          simd::SetEpi32(*reinterpret_cast<I32 *>(&feature_output[idx]));
+      const auto feature_vector_two =
+          simd::SetEpi32(*reinterpret_cast<I32 *>(&feature_output[idx_two]));
+      for (int j = 0; j < arch::kL2Size; j += kI32ChunkSize) {
+        const auto weight_vector = *reinterpret_cast<const simd::Vepi8 *>(
+            &network.l1_weights[bucket][idx + j / 4]);
+        const auto weight_vector_two = *reinterpret_cast<const simd::Vepi8 *>(
+            &network.l1_weights[bucket][idx_two + j / 4]);
+        auto &features = *reinterpret_cast<simd::Vepi32 *>(&l1_sums[j]);
+        features = simd::DpbusdEpi32x2(features,
+                                       feature_vector,
+                                       weight_vector,
+                                       feature_vector_two,
+                                       weight_vector_two);
+      }
+    }
+
+    // Handle the remaining features
+    for (; i < nnz_count; i++) {
+      const int idx = nnz_indices[i] * 4;
+      const auto feature_vector =
+          simd::SetEpi32(*reinterpret_cast<I32 *>(&feature_output[idx]));
+      for (int j = 0; j < arch::kL2Size; j += kI32ChunkSize) {
+        const auto weight_vector = *reinterpret_cast<const simd::Vepi8 *>(
+            &network.l1_weights[bucket][idx + j / 4]);
+        auto &features = *reinterpret_cast<simd::Vepi32 *>(&l1_sums[j]);
+        features = simd::DpbusdEpi32(features, feature_vector, weight_vector);
+      }
+    }
+  }
+
+  // Quantisation constants to convert to float
+  constexpr float kL1Normalization =
+      static_cast<float>(1 << kFtShift) /
+      static_cast<float>(arch::kFtQuantization * arch::kFtQuantization *
+                         arch::kL1Quantization);
+  const auto l1_multiplier_vector = simd::SetPs(kL1Normalization);
+  const auto zero_float_vector = simd::ZeroPs(),
+             one_float_vector = simd::SetPs(1.0f);
+
+  alignas(simd::kAlignment) std::array<float, arch::kL2Size> l1_output{};
+  for (int i = 0; i < arch::kL2Size; i += kF32ChunkSize) {
+    const auto bias_vector =
+        *reinterpret_cast<const simd::Vepf32 *>(&network.l1_biases[bucket][i]);
+    const auto float_vector =
+        simd::ConvertEpi32ToPs(*reinterpret_cast<simd::Vepi32 *>(&l1_sums[i]));
+    const auto casted_sum =
+        simd::MultiplyAddPs(float_vector, l1_multiplier_vector, bias_vector);
+    auto &features = *reinterpret_cast<simd::Vepf32 *>(&l1_output[i]);
+    features = simd::MinPs(simd::MaxPs(casted_sum, zero_float_vector),
+                           one_float_vector);
+  }
+
+  // Forward the feature layer neurons to the 2nd layer
+  alignas(simd::kAlignment) std::array<float, arch::kL3Size> l2_sums;
+  std::memcpy(
+      l2_sums.data(), network.l2_biases[bucket].data(), sizeof(l2_sums));
+
+  for (int i = 0; i < arch::kL2Size; i++) {
+    const auto l1_vector = simd::SetPs(l1_output[i]);
+    for (int j = 0; j < arch::kL3Size; j += kF32ChunkSize) {
+      const auto weight_vector = *reinterpret_cast<const simd::Vepf32 *>(
+          &network.l2_weights[bucket][i][j]);
+      auto &features = *reinterpret_cast<simd::Vepf32 *>(&l2_sums[j]);
+      features = simd::MultiplyAddPs(weight_vector, l1_vector, features);
+    }
+  }
+
+  alignas(simd::kAlignment) std::array<float, arch::kL3Size> l2_output;
+  for (int i = 0; i < arch::kL3Size; i += kF32ChunkSize) {
+    const auto &sum_vector = *reinterpret_cast<simd::Vepf32 *>(&l2_sums[i]);
+    auto &features = *reinterpret_cast<simd::Vepf32 *>(&l2_output[i]);
+    features = simd::MinPs(simd::MaxPs(sum_vector, zero_float_vector),
+                           one_float_vector);
+  }
+
+  // Forward the feature layer neurons to the 3rd (final) layer
+  constexpr int kResultChunks = 64 / sizeof(simd::Vepf32);
+  const auto zero_ps = simd::SetPs(0.0f);
+
+  // A plain array, since the attributes of the vector type are dropped when
+  // it's used as a template argument
+  alignas(simd::kAlignment) simd::Vepf32 result_sums[kResultChunks];
+  std::fill_n(result_sums, kResultChunks, zero_ps);
+
+  for (int i = 0; i < arch::kL3Size / kF32ChunkSize; i += kResultChunks) {
+    for (int chunk = 0; chunk < kResultChunks; chunk++) {
+      const auto weight_vector = *reinterpret_cast<const simd::Vepf32 *>(
+          &network.l3_weights[bucket][(i + chunk) * kF32ChunkSize]);
+      const auto &l2_vector = *reinterpret_cast<simd::Vepf32 *>(
+          &l2_output[(i + chunk) * kF32ChunkSize]);
+      result_sums[chunk] =
+          simd::MultiplyAddPs(l2_vector, weight_vector, result_sums[chunk]);
+    }
+  }
+
+  const auto l3_output =
+      simd::ReduceAddPs(result_sums) + network.l3_biases[bucket];
+
+  return static_cast<Score>(l3_output * arch::kEvalScale);
+}
+
+#else
+
+[[nodiscard]] I32 CReLU(I16 value) {
+  return std::clamp<I32>(value, 0, arch::kFtQuantization);
+}
+
+[[nodiscard]] float CReLU(float value) {
+  return std::clamp(value, 0.0f, 1.0f);
+}
+
+Score Forward(const I16 *us,
+              const I16 *them,
+              const Network &network,
+              int bucket) {
+  constexpr int kFtShift = 9;
+
+  // Activate the feature layer via pair-wise CReLU multiplication
+  std::array<U8, arch::kL1Size> feature_output{};
+  for (int side = 0; side <= 1; side++) {
+    const I16 *stm_accumulator = side == 0 ? us : them;
+    for (int i = 0; i < arch::kL1Size / 2; i++) {
+      const auto first_val = CReLU(stm_accumulator[i]);
+      const auto second_val = CReLU(stm_accumulator[i + arch::kL1Size / 2]);
+
+      const auto product = (first_val * second_val) >> 9;
+      feature_output[i + side * arch::kL1Size / 2] = static_cast<U8>(product);
+    }
+  }
+
+#ifdef SPARSE_PERMUTE
+  sparse::CountActivations(feature_output);
+#endif
+
+  const float kL1Normalization =
+      static_cast<float>(1 << kFtShift) /
+      static_cast<float>(arch::kFtQuantization * arch::kFtQuantization *
+                         arch::kL1Quantization);
+
+  // Forward the feature layer neurons to the 2nd layer
+  std::array<I32, arch::kL2Size> l1_sums{};
+  for (int i = 0; i < arch::kL1Size; i++) {
+    if (!feature_output[i]) continue;
+
+    for (int j = 0; j < arch::kL2Size; j++) {
+      l1_sums[j] += feature_output[i] * network.l1_weights[bucket][i][j];
+    }
+  }
+
+  // Activate 2nd layer neurons
+  std::array<float, arch::kL2Size> l1_output{};
+  for (int i = 0; i < arch::kL2Size; i++) {
+    l1_output[i] = CReLU(static_cast<float>(l1_sums[i]) * kL1Normalization +
+                         network.l1_biases[bucket][i]);
+  }
+
+  // Forward the 2nd layer neurons to the 3rd layer
+  std::array<float, arch::kL3Size> l2_output{};
+  std::memcpy(
+      l2_output.data(), network.l2_biases[bucket].data(), sizeof(l2_output));
+  for (int i = 0; i < arch::kL2Size; i++) {
+    for (int j = 0; j < arch::kL3Size; j++) {
+      l2_output[j] = std::fma(
+          l1_output[i], network.l2_weights[bucket][i][j], l2_output[j]);
+    }
+  }
+
+  // Forward 3rd layer neurons to output layer
+  constexpr int kResultChunks = 64 / sizeof(float);
+  std::array<float, kResultChunks> result_sums{};
+
+  for (int i = 0; i < arch::kL3Size; i += kResultChunks) {
+    for (int chunk = 0; chunk < kResultChunks; chunk++) {
+      const float activated = CReLU(l2_output[i + chunk]);
+      result_sums[chunk] = std::fma(activated,
+                                    network.l3_weights[bucket][i + chunk],
+                                    result_sums[chunk]);
+    }
+  }
+
+  const float l3_output =
+      network.l3_biases[bucket] +
+      simd::ReduceAddPsRecursive(result_sums.data(), kResultChunks);
+
+  // Scale output
+  return static_cast<Score>(l3_output * arch::kEvalScale);
+}
+
+#endif
+
+}  // namespace
+
+namespace BUILD_SIMD_TARGET {
+
+const KernelSet kKernelSet = {
+    .name = INTEGRAL_KERNELS_NAME(BUILD_SIMD_TARGET),
+#if BUILD_HAS_SIMD and !defined(SPARSE_PERMUTE)
+    .prepare_network = PrepareNetwork,
+    // The rearranged layout only depends on the width of the registers
+    .network_layout = sizeof(simd::Vepi16),
+#else
+    .prepare_network = nullptr,
+    .network_layout = kGenericLayout,
+#endif
+    .update_accumulator = UpdateAccumulator,
+    .forward = Forward,
+};
+
+}  // namespace BUILD_SIMD_TARGET
+
+}  // namespace nnue::kernels
+
+#endif  // INTEGRAL_NNUE_KERNELS_IMPL_H
@@ -1,6 +1,9 @@
 #ifndef INTEGRAL_NNUE_H
 #define INTEGRAL_NNUE_H
 
+#include <optional>
+#include <string>
+
 #include "../../../../shared/multi_array.h"
 #include "../../../../shared/nnue/definitions.h"
 #include "../../../../shared/simd.h"
@@ -9,12 +12,41 @@
 
 namespace nnue {
 
-inline Network* network = nullptr;
+// The network that every thread evaluates, unless it uses a NUMA replica
+inline const Network* shared_network = nullptr;
+
+// The network evaluated by the calling thread. This is either the shared
+// network or a replica local to the NUMA node the thread is bound to
+inline thread_local const Network* network = nullptr;
 
 class Accumulator;
 
+// Makes the network embedded in the executable the shared network, unless it
+// already is
 void LoadFromIncBin();
 
+// Makes the network in the given file the shared network. The file is either
+// written by the preprocessor or network save, or comes straight from the
+// trainer, in which case it's processed the same way as by the preprocessor.
+// Files already in the layout of the kernels are mapped read-only, so that
+// every process that loads the same file shares a single copy in memory.
+// Returns why the file was rejected, in which case the network is unchanged.
+// Threads that aren't the caller have to call UseNetwork() again afterwards.
+// A loaded file must only ever be replaced (written elsewhere and renamed over
+// it), never rewritten in place, since truncating a mapped file crashes every
+// process that evaluates from it
+[[nodiscard]] std::optional<std::string> LoadFromFile(const std::string& path);
+
+// Writes the shared network in the layout of the kernels that were picked for
+// this CPU, so that loading the file never has to copy the network. An existing
+// file is replaced atomically, so that it can be the file that's loaded
+[[nodiscard]] bool SaveToFile(const std::string& path);
+
+// Points the calling thread at the shared network, or at the replica for the
+// given NUMA node if one is provided. Replicas are created by the first thread
+// on their node so that their pages are allocated in node-local memory
+void UseNetwork(int numa_node = -1);
+
 Score Evaluate(Board& board);
 
 }  // namespace nnue
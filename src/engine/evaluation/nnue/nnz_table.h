@@ -0,0 +1,35 @@
+#ifndef INTEGRAL_NNZ_TABLE_H
+#define INTEGRAL_NNZ_TABLE_H
+
+#include <array>
+#include <bit>
+
+#include "../../../../shared/simd.h"
+#include "../../../utils/types.h"
+
+// Kept apart from the rest of the sparse code so that the kernels, which are
+// compiled once for every target, don't depend on the board
+namespace nnue::sparse {
+
+// We store the number and index of each set bit for every possible U8 number
+struct NnzEntry {
+  std::array<U16, 8> indices;
+};
+
+[[nodiscard]] constexpr std::array<NnzEntry, 256> GenerateNnzTable() {
+  std::array<NnzEntry, 256> table{};
+  for (int i = 0; i < 256; i++) {
+    // Save the index of every set bit
+    int num_bits = 0;
+    for (unsigned bits = i; bits; bits &= bits - 1) {
+      table[i].indices[num_bits++] = std::countr_zero(bits);
+    }
+  }
+  return table;
+}
+
+alignas(simd::kAlignment) constexpr auto nnz_table = GenerateNnzTable();
+
+}  // namespace nnue::sparse
+
+#endif  // INTEGRAL_NNZ_TABLE_H
@@ -7,31 +7,11 @@
 #include "../../../chess/bitboard.h"
 #include "../../../utils/types.h"
 #include "nnue.h"
+#include "nnz_table.h"
 
 // #if BUILD_HAS_SIMD
 namespace nnue::sparse {
 
-// We store the number and index of each set bit for every possible U8 number
-struct NnzEntry {
-  std::array<U16, 8> indices;
-};
-
-[[nodiscard]] constexpr std::array<NnzEntry, 256> GenerateNnzTable() {
-  std::array<NnzEntry, 256> table{};
-  for (I16 i = 0; i < 256; i++) {
-    // Save the index of every set bit
-    int num_bits = 0;
-    BitBoard bits = i;
-    while (bits) {
-      const int set_bit = bits.PopLsb();
-      table[i].indices[num_bits++] = set_bit;
-    }
-  }
-  return table;
-}
-
-alignas(simd::kAlignment) constexpr auto nnz_table = GenerateNnzTable();
-
 #ifdef SPARSE_PERMUTE
 //  This is the array where we keep track of the number of pair-wise activated
 //  neurons during a bench sequence, to be used for permuting the input and L1
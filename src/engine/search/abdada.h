@@ -0,0 +1,103 @@
+#ifndef INTEGRAL_ABDADA_H
+#define INTEGRAL_ABDADA_H
+
+#include <array>
+#include <atomic>
+#include <limits>
+
+#include "../../chess/move.h"
+#include "../../utils/list.h"
+#include "../../utils/types.h"
+
+namespace search {
+
+// Minimum depth at which moves are marked as being searched, since the
+// bookkeeping isn't worth it near the leaves
+constexpr int kAbdadaMinDepth = 4;
+
+// Only a few moves of a node are ever busy at once, and moves past this many
+// are searched right away instead of being deferred
+constexpr int kMaxDeferredMoves = 16;
+
+// A move that was deferred along with the extension that was decided for it,
+// so that it's searched exactly as it would have been
+struct DeferredMove {
+  Move move;
+  int extensions;
+};
+
+using DeferredMoveList = List<DeferredMove, kMaxDeferredMoves>;
+
+// A small lock-free table of the positions that are currently being searched
+// and at which depth, which lets threads defer moves that another thread is
+// already working on in the style of ABDADA. The table is only a hint: races
+// between threads may cause a move to be searched twice, but never skipped
+class AbdadaTable {
+ public:
+  AbdadaTable() {
+    Clear();
+  }
+
+  void Clear() {
+    for (auto &slot : slots_) {
+      slot.key.store(0, std::memory_order_relaxed);
+      slot.owner.store(kNoOwner, std::memory_order_relaxed);
+      slot.depth.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Marks the position as being searched by the thread, returning whether the
+  // slot was claimed. Positions that collide with an occupied slot are not
+  // marked
+  bool Enter(U64 key, int depth, U32 thread_id) {
+    auto &slot = slots_[Index(key)];
+
+    U32 expected = kNoOwner;
+    if (!slot.owner.compare_exchange_strong(
+            expected, thread_id, std::memory_order_acq_rel)) {
+      return false;
+    }
+
+    slot.depth.store(depth, std::memory_order_relaxed);
+    slot.key.store(key, std::memory_order_release);
+    return true;
+  }
+
+  // Releases a slot that was claimed with Enter()
+  void Leave(U64 key) {
+    auto &slot = slots_[Index(key)];
+    slot.key.store(0, std::memory_order_relaxed);
+    slot.owner.store(kNoOwner, std::memory_order_release);
+  }
+
+  // Returns whether a different thread is searching the position at the given
+  // depth or deeper
+  [[nodiscard]] bool IsBusy(U64 key, int depth, U32 thread_id) const {
+    const auto &slot = slots_[Index(key)];
+
+    const U32 owner = slot.owner.load(std::memory_order_acquire);
+    return owner != kNoOwner && owner != thread_id &&
+           slot.key.load(std::memory_order_acquire) == key &&
+           slot.depth.load(std::memory_order_relaxed) >= depth;
+  }
+
+ private:
+  static constexpr std::size_t kTableSize = 4096;
+  static constexpr U32 kNoOwner = std::numeric_limits<U32>::max();
+
+  [[nodiscard]] static std::size_t Index(U64 key) {
+    return key & (kTableSize - 1);
+  }
+
+  struct Slot {
+    std::atomic<U64> key;
+    std::atomic<U32> owner;
+    std::atomic<I32> depth;
+  };
+
+  std::array<Slot, kTableSize> slots_;
+};
+
+}  // namespace search
+
+#endif  // INTEGRAL_ABDADA_H
@@ -1,14 +1,16 @@
 #ifndef INTEGRAL_CUCKOO_H
 #define INTEGRAL_CUCKOO_H
 
+#include <cassert>
+
 #include "../../chess/move_gen.h"
+#include "../../magics/attacks.h"
 #include "../../utils/types.h"
 #include "../../utils/zobrist.h"
 
 namespace search::cuckoo {
 
-inline std::array<U64, 8192> keys;
-inline std::array<Move, 8192> moves;
+constexpr int kTableSize = 8192;
 
 constexpr U64 H1(U64 key) {
   return static_cast<U64>(key & 0x1FFF);
@@ -18,8 +20,79 @@ constexpr U64 H2(U64 key) {
   return static_cast<U64>((key >> 16) & 0x1FFF);
 }
 
-void Initialize();
+// The reversible moves of every piece on an empty board, keyed by how they
+// change the zobrist key of a position
+struct Tables {
+  std::array<U64, kTableSize> keys;
+  std::array<Move, kTableSize> moves;
+};
+
+constexpr Tables GenerateTables() {
+  Tables tables{};
+  tables.moves.fill(Move::NullMove());
+
+  [[maybe_unused]] U32 count = 0;
+
+  for (int piece = kKnight; piece <= kKing; ++piece) {
+    for (Color color : {Color::kWhite, Color::kBlack}) {
+      const int colored_piece = piece * 2 + color;
+      for (int from = 0; from < 64; ++from) {
+        for (int to = from + 1; to < 64; ++to) {
+          BitBoard possible_moves;
+          switch (piece) {
+            case PieceType::kKnight:
+              possible_moves = move_gen::kKnightMasks[from];
+              break;
+            case PieceType::kBishop:
+              possible_moves = magics::attacks::GenerateBishopMoves(from, 0);
+              break;
+            case PieceType::kRook:
+              possible_moves = magics::attacks::GenerateRookMoves(from, 0);
+              break;
+            case PieceType::kQueen:
+              possible_moves = magics::attacks::GenerateBishopMoves(from, 0) |
+                               magics::attacks::GenerateRookMoves(from, 0);
+              break;
+            case PieceType::kKing:
+              possible_moves = move_gen::kKingMasks[from];
+              break;
+          }
+
+          if (!possible_moves.IsSet(to)) {
+            continue;
+          }
+
+          auto move = Move(from, to);
+          auto key = zobrist::pieces[colored_piece][from] ^
+                     zobrist::pieces[colored_piece][to] ^ zobrist::turn;
+          U32 slot = H1(key);
+
+          while (true) {
+            std::swap(tables.keys[slot], key);
+            std::swap(tables.moves[slot], move);
+
+            if (move == Move::NullMove()) {
+              break;
+            }
+
+            slot = slot == H1(key) ? H2(key) : H1(key);
+          }
+
+          ++count;
+        }
+      }
+    }
+  }
+
+  assert(count == 3668);
+  return tables;
+}
+
+inline constexpr Tables kTables = GenerateTables();
+
+inline constexpr const std::array<U64, kTableSize> &keys = kTables.keys;
+inline constexpr const std::array<Move, kTableSize> &moves = kTables.moves;
 
 }  // namespace search::cuckoo
 
-#endif  // INTEGRAL_CUCKOO_H
\ No newline at end of file
+#endif  // INTEGRAL_CUCKOO_H
@@ -31,10 +31,21 @@ class ContinuationHistory {
                        Move move,
                        I16 bonus,
                        StackEntry *stack) {
-    UpdateIndividualScore(state, move, bonus, stack - 1);
-    UpdateIndividualScore(state, move, bonus, stack - 2);
-    UpdateIndividualScore(state, move, bonus, stack - 4);
-    UpdateIndividualScore(state, move, bonus, stack - 6);
+    UpdateMoveScore(state.turn,
+                    state.GetPieceType(move.GetFrom()),
+                    move.GetTo(),
+                    bonus,
+                    stack);
+  }
+
+  // Updates the score of a move that was already made by the given side and
+  // piece
+  void UpdateMoveScore(
+      Color turn, PieceType piece, Square to, I16 bonus, StackEntry *stack) {
+    UpdateIndividualScore(turn, piece, to, bonus, stack - 1);
+    UpdateIndividualScore(turn, piece, to, bonus, stack - 2);
+    UpdateIndividualScore(turn, piece, to, bonus, stack - 4);
+    UpdateIndividualScore(turn, piece, to, bonus, stack - 6);
   }
 
   [[nodiscard]] ContinuationEntry *GetEntry(const BoardState &state,
@@ -58,19 +69,14 @@ class ContinuationHistory {
   }
 
  private:
-  void UpdateIndividualScore(const BoardState &state,
-                             Move move,
-                             int bonus,
-                             StackEntry *stack) {
+  void UpdateIndividualScore(
+      Color turn, PieceType piece, Square to, int bonus, StackEntry *stack) {
     if (!stack->continuation_entry) {
       return;
     }
 
-    const int piece = state.GetPieceType(move.GetFrom());
-    const int to = move.GetTo();
-
     auto &entry = *stack->continuation_entry;
-    I16 &score = entry[state.turn][piece][to];
+    I16 &score = entry[turn][piece][to];
     score += ScaleBonus(score, bonus);
   }
 
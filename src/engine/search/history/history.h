@@ -2,6 +2,7 @@
 #define INTEGRAL_HISTORY_H
 
 #include "../../../chess/board.h"
+#include "../../../utils/large_pages.h"
 #include "capture_history.h"
 #include "continuation_history.h"
 #include "correction_history.h"
@@ -27,9 +28,9 @@ class History {
   void Initialize() {
     quiet_history = std::make_unique<QuietHistory>();
     continuation_history = std::make_unique<ContinuationHistory>();
-    correction_history = std::make_unique<CorrectionHistory>();
+    correction_history = memory::MakeLargePageUnique<CorrectionHistory>();
     capture_history = std::make_unique<CaptureHistory>();
-    pawn_history = std::make_unique<PawnHistory>();
+    pawn_history = memory::MakeLargePageUnique<PawnHistory>();
   }
 
   // Reinitialize the history objects for quicker clearing
@@ -69,9 +70,9 @@ class History {
  public:
   std::unique_ptr<QuietHistory> quiet_history;
   std::unique_ptr<CaptureHistory> capture_history;
-  std::unique_ptr<PawnHistory> pawn_history;
+  memory::LargePagePtr<PawnHistory> pawn_history;
   std::unique_ptr<ContinuationHistory> continuation_history;
-  std::unique_ptr<CorrectionHistory> correction_history;
+  memory::LargePagePtr<CorrectionHistory> correction_history;
 };
 
 }  // namespace search::history
@@ -16,9 +16,19 @@ class PawnHistory {
   }
 
   void UpdateMoveScore(const BoardState &state, Move move, I16 bonus) {
+    UpdateMoveScore(state.pawn_key,
+                    state.turn,
+                    state.GetPieceType(move.GetFrom()),
+                    move.GetTo(),
+                    bonus);
+  }
+
+  // Updates the score of a move that was already made, given the pawn key of
+  // the position that it was made in
+  void UpdateMoveScore(
+      U64 pawn_key, Color turn, PieceType piece, Square to, I16 bonus) {
     // Apply a linear dampening to the bonus as the depth increases
-    I16 &score = table_[GetIndex(state)][state.turn]
-                       [state.GetPieceType(move.GetFrom())][move.GetTo()];
+    I16 &score = table_[GetIndex(pawn_key)][turn][piece][to];
     score += ScaleBonus(score, bonus);
   }
 
@@ -39,13 +49,13 @@ class PawnHistory {
   }
 
   [[nodiscard]] int GetScore(const BoardState &state, Move move) const {
-    return table_[GetIndex(state)][state.turn]
+    return table_[GetIndex(state.pawn_key)][state.turn]
                  [state.GetPieceType(move.GetFrom())][move.GetTo()];
   }
 
  private:
-  [[nodiscard]] int GetIndex(const BoardState &state) const {
-    return state.pawn_key & 16383;
+  [[nodiscard]] int GetIndex(U64 pawn_key) const {
+    return pawn_key & 16383;
   }
 
  private:
@@ -50,9 +50,13 @@ Move MovePicker::Next() {
   const auto &state = board_.GetState();
 
   if (stage_ == Stage::kTTMove) {
-    stage_ = Stage::kGenerateNoisys;
+    stage_ = state.InCheck() ? Stage::kGenerateEvasions
+                             : Stage::kGenerateNoisys;
 
-    if (tt_move_ && board_.IsMovePseudoLegal(tt_move_)) {
+    // The generated moves are legal, so only the moves that didn't come from
+    // the move generator have to be verified in full
+    if (tt_move_ && board_.IsMovePseudoLegal(tt_move_) &&
+        board_.IsMoveLegal(tt_move_)) {
       if (type_ != MovePickerType::kQuiescence || state.InCheck() ||
           tt_move_.IsNoisy(state)) {
         return tt_move_;
@@ -60,9 +64,14 @@ Move MovePicker::Next() {
     }
   }
 
+  if (stage_ == Stage::kGenerateEvasions) {
+    stage_ = Stage::kGoodNoisys;
+    GenerateEvasions();
+  }
+
   if (stage_ == Stage::kGenerateNoisys) {
     stage_ = Stage::kGoodNoisys;
-    GenerateAndScoreMoves<MoveGenType::kNoisy>(noisys_);
+    GenerateAndScoreMoves<MoveGenType::kLegalNoisy>(noisys_);
   }
 
   if (stage_ == Stage::kGoodNoisys) {
@@ -96,7 +105,8 @@ Move MovePicker::Next() {
       const auto first_killer = stack_->killer_moves[0];
       if (first_killer && first_killer != tt_move_ &&
           !first_killer.IsNoisy(state) &&
-          board_.IsMovePseudoLegal(first_killer)) {
+          board_.IsMovePseudoLegal(first_killer) &&
+          board_.IsMoveLegal(first_killer)) {
         return first_killer;
       }
     }
@@ -109,7 +119,8 @@ Move MovePicker::Next() {
       const auto second_killer = stack_->killer_moves[1];
       if (second_killer && second_killer != tt_move_ &&
           !second_killer.IsNoisy(state) &&
-          board_.IsMovePseudoLegal(second_killer)) {
+          board_.IsMovePseudoLegal(second_killer) &&
+          board_.IsMoveLegal(second_killer)) {
         return second_killer;
       }
     }
@@ -118,7 +129,16 @@ Move MovePicker::Next() {
   if (stage_ == Stage::kGenerateQuiets) {
     stage_ = Stage::kQuiets;
     moves_idx_ = 0;
-    GenerateAndScoreMoves<MoveGenType::kQuiet>(quiets_);
+    if (state.InCheck()) {
+      // The quiet evasions were generated along with the noisy ones, but are
+      // only scored now so that they see the history updates of the moves
+      // searched before them
+      for (int i = 0; i < quiets_.Size(); i++) {
+        quiets_[i].score = ScoreMove(quiets_[i].move);
+      }
+    } else {
+      GenerateAndScoreMoves<MoveGenType::kLegalQuiet>(quiets_);
+    }
   }
 
   if (stage_ == Stage::kQuiets) {
@@ -184,6 +204,26 @@ void MovePicker::GenerateAndScoreMoves(List<ScoredMove, kMaxMoves> &list) {
   }
 }
 
+void MovePicker::GenerateEvasions() {
+  const auto &state = board_.GetState();
+  const auto &killers = stack_->killer_moves;
+
+  // Only the king, a capture of the checker or a block can get out of check,
+  // so the legal moves are few enough to generate in a single pass and split
+  // up for the regular noisy and quiet stages
+  auto moves = move_gen::GenerateMoves<MoveGenType::kLegalAll>(board_);
+  for (int i = 0; i < moves.Size(); i++) {
+    auto move = moves[i];
+    if (move == tt_move_) continue;
+
+    if (move.IsNoisy(state)) {
+      noisys_.Push({move, ScoreMove(move)});
+    } else if (move != killers[0] && move != killers[1]) {
+      quiets_.Push({move, 0});
+    }
+  }
+}
+
 int MovePicker::ScoreMove(Move &move) {
   const auto from = move.GetFrom();
   const auto to = move.GetTo();
@@ -211,10 +251,10 @@ int MovePicker::ScoreMove(Move &move) {
     return victim_value + history_.GetCaptureMoveScore(state, move);
   }
 
-  const BitBoard pawn_threats = state.threatened_by[kPawn];
-  const BitBoard minor_threats = pawn_threats | state.threatened_by[kKnight] |
-                                 state.threatened_by[kBishop];
-  const BitBoard rook_threats = minor_threats | state.threatened_by[kRook];
+  const BitBoard pawn_threats = state.ThreatenedBy(kPawn);
+  const BitBoard minor_threats = pawn_threats | state.ThreatenedBy(kKnight) |
+                                 state.ThreatenedBy(kBishop);
+  const BitBoard rook_threats = minor_threats | state.ThreatenedBy(kRook);
 
   int threat_score = 0;
   switch (state.GetPieceType(from)) {
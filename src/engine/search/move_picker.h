@@ -24,6 +24,7 @@ class MovePicker {
  public:
   enum class Stage {
     kTTMove,
+    kGenerateEvasions,
     kGenerateNoisys,
     kGoodNoisys,
     kFirstKiller,
@@ -54,6 +55,8 @@ class MovePicker {
   template <MoveGenType move_type>
   void GenerateAndScoreMoves(List<ScoredMove, kMaxMoves> &list);
 
+  void GenerateEvasions();
+
   int ScoreMove(Move &move);
 
  private:
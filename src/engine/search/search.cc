@@ -5,6 +5,8 @@
 #include <thread>
 
 #include "../../data_gen/data_gen.h"
+#include "../../utils/numa.h"
+#include "../evaluation/nnue/nnue.h"
 #include "../uci/reporter.h"
 #include "constants.h"
 #include "fmt/format.h"
@@ -21,13 +23,35 @@ namespace tables {
 using LateMoveReductionTable =
     MultiArray<int, 2, kMaxSearchDepth + 1, kMaxMoves>;
 
-int CalculateLMR(int depth, int moves, double base, double divisor) {
-  auto ln_depth = std::log(depth), ln_moves = std::log(moves);
-  return static_cast<int>(base + ln_depth * ln_moves / divisor);
+// Natural logarithm of a positive integer that can be evaluated at compile
+// time, which matches std::log exactly over the range of depths and moves
+constexpr double Log(int value) {
+  constexpr long double kLn2 = 0.693147180559945309417232121458176568L;
+
+  // Reduce to a mantissa in [1, 2) and sum the series of 2 * atanh(z)
+  int exponent = 0;
+  long double mantissa = value;
+  while (mantissa >= 2) {
+    mantissa /= 2;
+    exponent++;
+  }
+
+  const long double z = (mantissa - 1) / (mantissa + 1);
+  long double term = z, sum = 0;
+  for (int i = 1; i < 64; i += 2) {
+    sum += term / i;
+    term *= z * z;
+  }
+
+  return static_cast<double>(exponent * kLn2 + 2 * sum);
 }
 
-LateMoveReductionTable GenerateLateMoveReductionTable() {
-  LateMoveReductionTable table;
+constexpr int CalculateLMR(int depth, int moves, double base, double divisor) {
+  return static_cast<int>(base + Log(depth) * Log(moves) / divisor);
+}
+
+constexpr LateMoveReductionTable GenerateLateMoveReductionTable() {
+  LateMoveReductionTable table{};
 
   // Initialize the depth reduction table for Late Move Reduction
   for (int depth = 1; depth <= kMaxSearchDepth; depth++) {
@@ -42,8 +66,15 @@ LateMoveReductionTable GenerateLateMoveReductionTable() {
   return table;
 }
 
+#ifdef SPSA_TUNE
+// The reduction parameters change while tuning, so the table is rebuilt for
+// every new game
 inline LateMoveReductionTable kLateMoveReduction =
     GenerateLateMoveReductionTable();
+#else
+constexpr LateMoveReductionTable kLateMoveReduction =
+    GenerateLateMoveReductionTable();
+#endif
 
 }  // namespace tables
 
@@ -149,8 +180,12 @@ void Searcher::IterativeDeepening(Thread &thread) {
         time_mgmt_.ShouldStop(best_move.move, depth, thread);
     const bool hard_timeout = ShouldQuit();
 
-    if (regular_search && (!minimal || soft_timeout) && thread.IsMainThread() &&
-        !hard_timeout) {
+    if (regular_search && !silent_ && (!minimal || soft_timeout) &&
+        thread.IsMainThread() && !hard_timeout) {
+      // The other threads publish their counts periodically, but our own
+      // count should be exact
+      thread.PublishStats();
+
       for (int i = 0; i < multi_pv; ++i) {
         auto &pv_move = thread.root_moves[i];
 
@@ -182,13 +217,13 @@ void Searcher::IterativeDeepening(Thread &thread) {
   thread.previous_score = best_move.score;
 
   const auto SendStoppedSignal = [&]() {
+    thread.stats.accumulator_refreshes =
+        thread.board.GetAccumulator()->GetRefreshCount();
+    thread.PublishStats();
+
     if constexpr (type == SearchType::kRegular) {
-      {
-        std::unique_lock lock(thread_stopped_mutex_);
-        // Wait on the other threads to finish before reporting the best move
-        --searching_threads_;
-        thread_stopped_signal_.notify_all();
-      }
+      SignalThreadStopped();
+      // Wait on the other threads to finish before reporting the best move
       search_end_barrier_.ArriveAndWait();
     }
   };
@@ -203,10 +238,19 @@ void Searcher::IterativeDeepening(Thread &thread) {
     stop_.store(true, std::memory_order_seq_cst);
     SendStoppedSignal();
 
+    // Every thread has finished by now, so their counters can be read
+    if (regular_search) {
+      SetLastSearchStats(GetStats());
+    }
+
     // Age the transposition table to recognize TT entries from past searches
     transposition_table_.Age();
 
-    if (regular_search) {
+    if (regular_search && !silent_) {
+      if (numa_aware_ && numa::NodeCount() > 1) {
+        ReportNumaNodes();
+      }
+
       fmt::println(
           "bestmove {}",
           !thread.root_moves.Empty() ? best_move.move.ToString() : "0000");
@@ -270,8 +314,12 @@ Score Searcher::QuiescentSearch(Thread &thread,
       state.zobrist_key ^ zobrist::fifty_move[state.fifty_moves_clock];
 
   const int tt_depth = state.InCheck();
-  const auto tt_entry = transposition_table_.Probe(zobrist_key);
-  const bool tt_hit = tt_entry->CompareKey(zobrist_key);
+  const auto tt_probe = transposition_table_.Probe(zobrist_key);
+  const auto tt_entry = &tt_probe.entry;
+  const bool tt_hit = tt_probe.hit;
+  thread.stats.tt_hits += tt_hit;
+  thread.stats.tt_misses += !tt_hit;
+  thread.stats.tt_collisions += tt_probe.collisions;
 
   auto tt_move = Move::NullMove();
   bool tt_was_in_pv = in_pv_node;
@@ -322,7 +370,6 @@ Score Searcher::QuiescentSearch(Thread &thread,
       // Save the static eval in the TT if we have nothing yet
       if (!tt_hit) {
         const TranspositionTableEntry new_tt_entry(
-            zobrist_key,
             tt_depth,
             TranspositionTableEntry::kNone,
             kScoreNone,
@@ -330,7 +377,7 @@ Score Searcher::QuiescentSearch(Thread &thread,
             Move::NullMove(),
             tt_was_in_pv);
         transposition_table_.Save(
-            tt_entry, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
+            tt_probe, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
       }
 
       return static_cast<Score>(
@@ -341,7 +388,7 @@ Score Searcher::QuiescentSearch(Thread &thread,
     alpha = std::max(alpha, best_score);
   }
 
-  stack->threats = state.threats;
+  stack->threats = state.Threats();
 
   const Score futility_score = best_score + kQsFutMargin;
   // Keep track of quiet and capture moves that failed to cause a beta cutoff
@@ -358,10 +405,6 @@ Score Searcher::QuiescentSearch(Thread &thread,
       break;
     }
 
-    if (!board.IsMoveLegal(move)) {
-      continue;
-    }
-
     // QS Futility Pruning: Prune noisy moves that don't win material if the
     // static eval is behind alpha by some margin
     if (!stack->in_check &&
@@ -387,7 +430,8 @@ Score Searcher::QuiescentSearch(Thread &thread,
         history.correction_history->GetContEntry(state, move);
     stack->history_score = history.GetMoveScore(state, move, stack);
 
-    thread.nodes_searched.fetch_add(1, std::memory_order_relaxed);
+    thread.CountNode();
+    thread.stats.qsearch_nodes++;
 
     board.MakeMove(move);
     const Score score =
@@ -453,15 +497,14 @@ Score Searcher::QuiescentSearch(Thread &thread,
 
   // Always updating the transposition table a depth 0 limits these TT entries
   // to the quiescent search only
-  const TranspositionTableEntry new_tt_entry(zobrist_key,
-                                             tt_depth,
+  const TranspositionTableEntry new_tt_entry(tt_depth,
                                              tt_flag,
                                              best_score,
                                              raw_static_eval,
                                              Move::NullMove(),
                                              tt_was_in_pv);
   transposition_table_.Save(
-      tt_entry, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
+      tt_probe, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
 
   return best_score;
 }
@@ -480,7 +523,7 @@ Score Searcher::PVSearch(Thread &thread,
   static thread_local int counter = 0;
   if (thread.IsMainThread() && (++counter & 4095) == 0) {
     counter = 0;
-    if (time_mgmt_.TimesUp(thread.nodes_searched)) {
+    if (time_mgmt_.TimesUp(thread.stats.nodes)) {
       stop_.store(true, std::memory_order_relaxed);
     }
   }
@@ -547,8 +590,12 @@ Score Searcher::PVSearch(Thread &thread,
   const U64 zobrist_key =
       state.zobrist_key ^ zobrist::fifty_move[state.fifty_moves_clock];
 
-  const auto &tt_entry = transposition_table_.Probe(zobrist_key);
-  tt_hit = tt_entry->CompareKey(zobrist_key);
+  const auto tt_probe = transposition_table_.Probe(zobrist_key);
+  const auto tt_entry = &tt_probe.entry;
+  tt_hit = tt_probe.hit;
+  thread.stats.tt_hits += tt_hit;
+  thread.stats.tt_misses += !tt_hit;
+  thread.stats.tt_collisions += tt_probe.collisions;
 
   // Use the TT entry's evaluation if possible
   if (tt_hit) {
@@ -593,21 +640,20 @@ Score Searcher::PVSearch(Thread &thread,
         tt_flag = TranspositionTableEntry::kExact;
       }
 
-      thread.tb_hits.fetch_add(1, std::memory_order_relaxed);
+      thread.stats.tb_hits++;
 
       if (tt_flag == TranspositionTableEntry::kExact ||
           tt_flag == TranspositionTableEntry::kUpperBound && score <= alpha ||
           tt_flag == TranspositionTableEntry::kLowerBound && score >= beta) {
         // Save the table base score to the transposition table
-        const TranspositionTableEntry new_tt_entry(zobrist_key,
-                                                   depth,
+        const TranspositionTableEntry new_tt_entry(depth,
                                                    tt_flag,
                                                    score,
                                                    tt_static_eval,
                                                    Move::NullMove(),
                                                    tt_was_in_pv);
         transposition_table_.Save(
-            tt_entry, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
+            tt_probe, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
         return score;
       }
 
@@ -635,15 +681,14 @@ Score Searcher::PVSearch(Thread &thread,
 
     // Save the static eval in the TT if we have nothing yet
     if (!tt_hit) {
-      const TranspositionTableEntry new_tt_entry(zobrist_key,
-                                                 0,
+      const TranspositionTableEntry new_tt_entry(0,
                                                  TranspositionTableEntry::kNone,
                                                  kScoreNone,
                                                  raw_static_eval,
                                                  Move::NullMove(),
                                                  tt_was_in_pv);
       transposition_table_.Save(
-          tt_entry, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
+          tt_probe, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
     }
 
     stack->static_eval = AdjustStaticEval(raw_static_eval, thread, stack);
@@ -670,11 +715,14 @@ Score Searcher::PVSearch(Thread &thread,
                                       kEvalHistUpdateMax);
     history.quiet_history->UpdateMoveScore(
         FlipColor(state.turn), prev_stack->move, prev_stack->threats, bonus);
-    history.pawn_history->UpdateMoveScore(
-        board.GetStateHistory().Back(), prev_stack->move, bonus);
+    history.pawn_history->UpdateMoveScore(board.GetPreviousPawnKey(),
+                                          FlipColor(state.turn),
+                                          prev_stack->moved_piece,
+                                          prev_stack->move.GetTo(),
+                                          bonus);
   }
 
-  stack->threats = state.threats;
+  stack->threats = state.Threats();
 
   // This condition is dependent on if the side to move's static evaluation
   // has improved in the past two or four plies. It also used as a metric for
@@ -756,6 +804,8 @@ Score Searcher::PVSearch(Thread &thread,
             depth / kNmpRedDiv + kNmpRedBase + eval_reduction + improving;
         reduction = std::clamp(reduction, 0, depth);
 
+        thread.stats.nmp_searches++;
+
         board.MakeNullMove();
         const Score score = -PVSearch<NodeType::kNonPV>(
             thread, depth - reduction, -beta, -beta + 1, stack + 1, !cut_node);
@@ -769,6 +819,8 @@ Score Searcher::PVSearch(Thread &thread,
         // indicates that the opponent still doesn't gain an advantage from
         // the null move
         if (score >= beta) {
+          thread.stats.nmp_cutoffs++;
+
           if (thread.nmp_min_ply != 0 || depth <= 14) {
             return score >= kTBWinInMaxPlyScore ? beta : score;
           }
@@ -800,7 +852,7 @@ Score Searcher::PVSearch(Thread &thread,
         MovePicker move_picker(
             MovePickerType::kNoisy, board, pc_tt_move, history, stack, pc_see);
         while (const auto move = move_picker.Next()) {
-          if (move == stack->excluded_tt_move || !board.IsMoveLegal(move)) {
+          if (move == stack->excluded_tt_move) {
             continue;
           }
 
@@ -816,7 +868,8 @@ Score Searcher::PVSearch(Thread &thread,
           stack->history_score = history.GetMoveScore(state, move, stack);
 
           const int probcut_depth = depth - 3;
-          thread.nodes_searched.fetch_add(1, std::memory_order_relaxed);
+          thread.CountNode();
+          thread.stats.probcut_searches++;
 
           board.MakeMove(move);
 
@@ -835,8 +888,9 @@ Score Searcher::PVSearch(Thread &thread,
           board.UndoMove();
 
           if (score >= pc_beta) {
+            thread.stats.probcut_cutoffs++;
+
             const TranspositionTableEntry new_tt_entry(
-                zobrist_key,
                 probcut_depth,
                 TranspositionTableEntry::kLowerBound,
                 score,
@@ -844,7 +898,7 @@ Score Searcher::PVSearch(Thread &thread,
                 Move::NullMove(),
                 tt_was_in_pv);
             transposition_table_.Save(
-                tt_entry, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
+                tt_probe, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
             return score;
           }
         }
@@ -871,17 +925,39 @@ Score Searcher::PVSearch(Thread &thread,
 
   MovePicker move_picker(
       MovePickerType::kSearch, board, tt_move, history, stack);
-  while (const auto move = move_picker.Next()) {
+
+  // Moves that were being searched by another thread when we reached them,
+  // which are searched once every other move has been tried (ABDADA). They
+  // already passed pruning, so they skip it when they're searched later. The
+  // list only exists at nodes where ABDADA is used
+  const bool use_abdada = abdada_ && !in_root && depth >= kAbdadaMinDepth;
+  std::optional<DeferredMoveList> deferred_moves;
+  if (use_abdada) deferred_moves.emplace();
+  int deferred_idx = 0;
+  const auto next_move = [&]() {
+    if (const auto move = move_picker.Next()) {
+      return move;
+    }
+    return deferred_moves && deferred_idx < deferred_moves->Size()
+               ? (*deferred_moves)[deferred_idx++].move
+               : Move::NullMove();
+  };
+
+  while (const auto move = next_move()) {
+    // Every move after the first deferred one is replayed from the list
+    const bool is_deferred = deferred_idx > 0;
+
     if (in_root && !thread.root_moves.MoveExists(move, thread.pv_move_idx)) {
       continue;
     }
 
-    if (move == stack->excluded_tt_move || !board.IsMoveLegal(move)) {
+    if (move == stack->excluded_tt_move) {
       continue;
     }
 
     // Prefetch the TT entry for the next move as early as possible
-    transposition_table_.Prefetch(board.PredictKeyAfter(move));
+    const U64 child_key = board.PredictKeyAfter(move);
+    transposition_table_.Prefetch(child_key);
 
     const bool is_quiet = !move.IsNoisy(state);
     const bool is_capture = move.IsCapture(state);
@@ -889,7 +965,7 @@ Score Searcher::PVSearch(Thread &thread,
     stack->history_score = history.GetMoveScore(state, move, stack);
 
     // Pruning guards
-    if (!in_root && best_score > -kTBWinInMaxPlyScore) {
+    if (!in_root && !is_deferred && best_score > -kTBWinInMaxPlyScore) {
       constexpr int kLmrDepthScale = 1024;
       int reduction = tables::kLateMoveReduction[is_quiet][depth][moves_seen] *
                       kLmrDepthScale;
@@ -966,8 +1042,9 @@ Score Searcher::PVSearch(Thread &thread,
     // Singular Extensions: If a TT move exists and its score is accurate
     // enough (close enough in depth), we perform a reduced-depth search with
     // the TT move excluded to see if any other moves can beat it.
-    int extensions = 0;
-    if (!in_root && depth >= kSeDepth && move == tt_move &&
+    int extensions =
+        is_deferred ? (*deferred_moves)[deferred_idx - 1].extensions : 0;
+    if (!in_root && !is_deferred && depth >= kSeDepth && move == tt_move &&
         tt_entry->depth + 3 >= depth &&
         tt_entry->flag != TranspositionTableEntry::kUpperBound &&
         std::abs(tt_entry->score) < kTBWinInMaxPlyScore &&
@@ -975,6 +1052,8 @@ Score Searcher::PVSearch(Thread &thread,
       const int reduced_depth = kSeDepthReduction * (depth - 1) / 16;
       const Score new_beta = tt_entry->score - kSeBetaMargin * depth / 16;
 
+      thread.stats.singular_searches++;
+
       stack->excluded_tt_move = tt_move;
       const Score tt_move_excluded_score = PVSearch<NodeType::kNonPV>(
           thread, reduced_depth, new_beta - 1, new_beta, stack, cut_node);
@@ -996,6 +1075,7 @@ Score Searcher::PVSearch(Thread &thread,
         } else {
           extensions = 1;
         }
+        thread.stats.singular_extensions++;
       }
       // Multi-cut: The singular search had a beta cutoff, indicating that
       // the TT move was not singular. Therefore, we prune if the same score
@@ -1013,6 +1093,21 @@ Score Searcher::PVSearch(Thread &thread,
       }
     }
 
+    // ABDADA: Search the eldest brother first, but defer the other moves
+    // while another thread is already searching them, since the result will
+    // likely be in the transposition table by the time we get back to them
+    bool marked_as_searching = false;
+    if (use_abdada) {
+      if (moves_seen > 0 && deferred_idx == 0 &&
+          deferred_moves->Size() < kMaxDeferredMoves &&
+          abdada_table_.IsBusy(child_key, depth, thread.id)) {
+        deferred_moves->Push({move, extensions});
+        continue;
+      }
+
+      marked_as_searching = abdada_table_.Enter(child_key, depth, thread.id);
+    }
+
     stack->move = move;
     stack->moved_piece = state.GetPieceType(move.GetFrom());
     stack->capture_move = is_capture;
@@ -1024,8 +1119,8 @@ Score Searcher::PVSearch(Thread &thread,
     board.MakeMove(move);
 
     const bool gives_check = state.InCheck();
-    const U32 prev_nodes_searched =
-        thread.nodes_searched.fetch_add(1, std::memory_order_relaxed);
+    const U64 prev_nodes_searched = thread.stats.nodes;
+    thread.CountNode();
 
     // Principal Variation Search (PVS)
     int new_depth = depth + extensions - 1;
@@ -1091,12 +1186,15 @@ Score Searcher::PVSearch(Thread &thread,
       reduction = std::clamp(reduction, -1, new_depth - 1);
 
       // Null window search at reduced depth to see if the move had potential
+      thread.stats.lmr_searches++;
       score = -PVSearch<NodeType::kNonPV>(
           thread, new_depth - reduction, -alpha - 1, -alpha, stack + 1, true);
 
       stack->reduction = 0;
 
       if ((needs_full_search = score > alpha && reduction != 0)) {
+        thread.stats.lmr_researches++;
+
         // Search deeper or shallower depending on if the result of the
         // reduced-depth search indicates a promising score
         const bool do_deeper_search = score > (best_score + kDoDeeperBase +
@@ -1121,8 +1219,11 @@ Score Searcher::PVSearch(Thread &thread,
         const int bonus = score <= alpha ? history::HistoryPenalty(new_depth)
                         : score >= beta  ? history::HistoryBonus(depth)
                                          : 0;
-        history.continuation_history->UpdateMoveScore(
-            board.GetStateHistory().Back(), move, bonus, stack);
+        history.continuation_history->UpdateMoveScore(FlipColor(state.turn),
+                                                      stack->moved_piece,
+                                                      move.GetTo(),
+                                                      bonus,
+                                                      stack);
       }
     }
 
@@ -1134,6 +1235,10 @@ Score Searcher::PVSearch(Thread &thread,
 
     board.UndoMove();
 
+    if (marked_as_searching) {
+      abdada_table_.Leave(child_key);
+    }
+
     if (ShouldQuit()) {
       return 0;
     }
@@ -1145,7 +1250,7 @@ Score Searcher::PVSearch(Thread &thread,
       if (thread.IsMainThread()) {
         if (auto timed_limiter = time_mgmt_.GetTimedLimiter()) {
           timed_limiter->NodesSpent(move) +=
-              thread.nodes_searched - prev_nodes_searched;
+              thread.stats.nodes - prev_nodes_searched;
         }
       }
 
@@ -1178,6 +1283,9 @@ Score Searcher::PVSearch(Thread &thread,
 
         alpha = score;
         if (alpha >= beta) {
+          thread.stats.beta_cutoffs++;
+          thread.stats.first_move_cutoffs += moves_seen == 1;
+
           const int history_depth =
               depth + (alpha > beta + kHistoryBonusMargin);
           if (is_quiet) {
@@ -1233,8 +1341,11 @@ Score Searcher::PVSearch(Thread &thread,
     const auto past_turn = FlipColor(state.turn);
     history.quiet_history->UpdateMoveScore(
         past_turn, prev_stack->move, prev_stack->threats, history_bonus);
-    history.pawn_history->UpdateMoveScore(
-        board.GetStateHistory().Back(), prev_stack->move, history_bonus / 2);
+    history.pawn_history->UpdateMoveScore(board.GetPreviousPawnKey(),
+                                          past_turn,
+                                          prev_stack->moved_piece,
+                                          prev_stack->move.GetTo(),
+                                          history_bonus / 2);
   }
 
   if (syzygy::enabled) {
@@ -1254,15 +1365,14 @@ Score Searcher::PVSearch(Thread &thread,
     if (!in_root || thread.pv_move_idx == 0) {
       // Attempt to update the transposition table with the evaluation of this
       // position
-      const TranspositionTableEntry new_tt_entry(zobrist_key,
-                                                 depth,
+      const TranspositionTableEntry new_tt_entry(depth,
                                                  tt_flag,
                                                  best_score,
                                                  raw_static_eval,
                                                  best_move,
                                                  tt_was_in_pv);
       transposition_table_.Save(
-          tt_entry, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
+          tt_probe, new_tt_entry, zobrist_key, stack->ply, in_pv_node);
     }
 
     if (!stack->in_check && (!best_move || !best_move.IsNoisy(state))) {
@@ -1285,19 +1395,55 @@ void Searcher::Run(Thread &thread) {
       return;
     }
 
+    if (task_) {
+      (*task_)(thread);
+      SignalThreadStopped();
+      continue;
+    }
+
     thread.Reset();
     thread.SetBoard(board_);
 
+    thread.perf_counters.Enable();
     IterativeDeepening<SearchType::kRegular>(thread);
+    thread.perf_counters.Disable();
   }
 }
 
-void Searcher::WaitForThreads() {
+void Searcher::RunOnThreads(const std::function<void(Thread &)> &task) {
+  if (threads_.empty()) {
+    return;
+  }
+
   if (searching_threads_.load() > 0) {
-    std::unique_lock lock(thread_stopped_mutex_);
-    thread_stopped_signal_.wait(lock, [this] {
-      return searching_threads_.load(std::memory_order_seq_cst) == 0;
-    });
+    Stop();
+  }
+
+  // Wait until all search threads have stopped
+  stop_barrier_.ArriveAndWait();
+
+  task_ = &task;
+  searching_threads_.store(static_cast<U16>(threads_.size()),
+                           std::memory_order_seq_cst);
+
+  start_barrier_.ArriveAndWait();
+  WaitForThreads();
+
+  task_ = nullptr;
+}
+
+void Searcher::WaitForThreads() {
+  int remaining;
+  while ((remaining = searching_threads_.load(std::memory_order_acquire)) > 0) {
+    SpinWait(searching_threads_, remaining);
+  }
+}
+
+void Searcher::SignalThreadStopped() {
+  // Only the last thread to stop can release a waiter, since it waits for the
+  // count to reach zero
+  if (searching_threads_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    searching_threads_.notify_all();
   }
 }
 
@@ -1326,6 +1472,33 @@ void Searcher::SetThreadCount(U16 count) {
     return;
   }
 
+  CreateThreads(count);
+}
+
+void Searcher::SetNumaAware(bool numa_aware) {
+  if (numa_aware_ == numa_aware) {
+    return;
+  }
+
+  numa_aware_ = numa_aware;
+
+  // The threads have to be recreated so that their data is allocated again
+  // after being bound to a node
+  if (!threads_.empty()) {
+    CreateThreads(threads_.size());
+  }
+}
+
+void Searcher::SetAbdada(bool enabled) {
+  abdada_ = enabled;
+  abdada_table_.Clear();
+}
+
+void Searcher::SetSilent(bool silent) {
+  silent_ = silent;
+}
+
+void Searcher::CreateThreads(U16 count) {
   if (!threads_.empty()) {
     QuitThreads();
   }
@@ -1347,7 +1520,15 @@ void Searcher::SetThreadCount(U16 count) {
 
   for (U16 i = 0; i < count; i++) {
     raw_threads_.emplace_back([this, i]() {
-      threads_[i] = std::make_unique<Thread>(i);
+      int numa_node = -1;
+      if (numa_aware_ && numa::NodeCount() > 1) {
+        numa_node = numa::NodeForThread(i);
+        if (!numa::BindThisThread(numa_node)) numa_node = -1;
+      }
+
+      nnue::UseNetwork(numa_node);
+
+      threads_[i] = std::make_unique<Thread>(i, numa_node);
       // Touch memory to enforce first-touch
       auto &thread = *threads_[i];
       thread.stack.Reset();
@@ -1374,6 +1555,12 @@ void Searcher::Start(TimeConfig time_config) {
   time_mgmt_.SetConfig(time_config);
   time_mgmt_.Start();
 
+  // Reset the node counts here as well, so that the counts of the previous
+  // search are never observed once the search has started
+  for (auto &thread : threads_) {
+    thread->published_nodes.store(0, std::memory_order_relaxed);
+  }
+
   searching_threads_.store(static_cast<U16>(threads_.size()),
                            std::memory_order_seq_cst);
 
@@ -1412,7 +1599,7 @@ U64 Searcher::Bench(std::unique_ptr<Thread> &thread, int depth) {
   time_mgmt_.Start();
 
   IterativeDeepening<SearchType::kBench>(*thread);
-  return thread->nodes_searched;
+  return thread->stats.nodes;
 }
 
 void Searcher::Stop() {
@@ -1420,15 +1607,25 @@ void Searcher::Stop() {
   WaitForThreads();
 }
 
+void Searcher::Wait() {
+  WaitForThreads();
+}
+
 void Searcher::NewGame(bool clear_tables) {
   if (clear_tables) {
-    transposition_table_.Clear(std::max<int>(1, threads_.size()));
+    if (!transposition_table_.NewEpoch()) {
+      ClearHash();
+    }
+#ifdef SPSA_TUNE
     tables::kLateMoveReduction = tables::GenerateLateMoveReductionTable();
+#endif
   }
 
-  for (auto &thread : threads_) {
-    thread->NewGame();
-  }
+  // Each thread clears its own history so that the tables stay allocated on
+  // the NUMA node it is bound to
+  RunOnThreads([](Thread &thread) {
+    thread.NewGame();
+  });
 }
 
 const TimeManagement &Searcher::GetTimeManagement() const {
@@ -1438,20 +1635,164 @@ const TimeManagement &Searcher::GetTimeManagement() const {
 U64 Searcher::GetNodesSearched() const {
   return std::accumulate(
       threads_.begin(), threads_.end(), 0ULL, [](auto sum, const auto &thread) {
-        return sum + thread->nodes_searched.load(std::memory_order_relaxed);
+        return sum + thread->published_nodes.load(std::memory_order_relaxed);
       });
 }
 
+void Searcher::ReportNumaNodes() {
+  const auto time_elapsed = std::max<U64>(1, time_mgmt_.TimeElapsed());
+
+  for (int node = 0; node < numa::NodeCount(); node++) {
+    int thread_count = 0;
+    U64 nodes_searched = 0;
+    for (const auto &thread : threads_) {
+      if (thread->numa_node == node) {
+        thread_count++;
+        nodes_searched +=
+            thread->published_nodes.load(std::memory_order_relaxed);
+      }
+    }
+
+    fmt::println("info string numa node {} threads {} nodes {} nps {}",
+                 numa::GetNodes()[node].id,
+                 thread_count,
+                 nodes_searched,
+                 nodes_searched * 1000 / time_elapsed);
+  }
+}
+
+SearchStats Searcher::GetStats() const {
+  SearchStats stats;
+  for (const auto &thread : threads_) {
+    stats += thread->stats;
+  }
+  return stats;
+}
+
+std::vector<SearchStats> Searcher::GetThreadStats() const {
+  std::vector<SearchStats> stats;
+  for (const auto &thread : threads_) {
+    stats.push_back(thread->stats);
+  }
+  return stats;
+}
+
 U64 Searcher::GetTbHits() const {
   return std::accumulate(
       threads_.begin(), threads_.end(), 0ULL, [](auto sum, const auto &thread) {
-        return sum + thread->tb_hits.load(std::memory_order_relaxed);
+        return sum + thread->published_tb_hits.load(std::memory_order_relaxed);
       });
 }
 
+memory::PageType Searcher::GetHashPageType() const {
+  return transposition_table_.GetPageType();
+}
+
 void Searcher::ResizeHash(U64 size) {
-  transposition_table_.Resize(size);
-  transposition_table_.Clear(std::max<int>(1, threads_.size()));
+  const auto old_size = GetHashSize();
+  if (old_size == 0) {
+    transposition_table_.Resize(size);
+    ClearHash();
+    return;
+  }
+
+  // Keep the old clusters until their entries were moved into the new table,
+  // so that resizing in the middle of a session keeps all of the analysis
+  const auto start_time = GetCurrentTime();
+  transposition_table_.BeginResize(size);
+
+  RunOnHashShares([this](int thread_idx, int thread_count) {
+    transposition_table_.Clear(thread_idx, thread_count);
+  });
+
+  std::atomic<U64> migrated = 0;
+  RunOnHashShares([this, &migrated](int thread_idx, int thread_count) {
+    migrated.fetch_add(transposition_table_.Migrate(thread_idx, thread_count),
+                       std::memory_order_relaxed);
+  });
+
+  transposition_table_.FinishResize();
+
+  fmt::println(
+      "info string Hash resized from {} MB to {} MB, migrated {} entries in {} "
+      "ms with a peak of {} MB",
+      old_size,
+      GetHashSize(),
+      migrated.load(),
+      GetCurrentTime() - start_time,
+      old_size + GetHashSize());
+}
+
+void Searcher::RunOnHashShares(const std::function<void(int, int)> &task) {
+  if (threads_.empty()) {
+    task(0, 1);
+  } else {
+    RunOnThreads([this, &task](Thread &thread) {
+      task(thread.id, threads_.size());
+    });
+  }
+}
+
+std::optional<std::string> Searcher::OpenPerfCounters() {
+  // Counters can only be opened for the calling thread
+  std::mutex error_mutex;
+  std::string error;
+  RunOnThreads([&](Thread &thread) {
+    if (!thread.perf_counters.Open()) {
+      std::lock_guard lock(error_mutex);
+      error = thread.perf_counters.GetError();
+    }
+  });
+
+  if (error.empty()) return std::nullopt;
+  return error;
+}
+
+std::vector<perf::Counts> Searcher::TakePerfCounts() {
+  std::vector<perf::Counts> counts;
+  for (auto &thread : threads_) {
+    counts.push_back(thread->perf_counters.Take());
+  }
+  return counts;
+}
+
+bool Searcher::SaveHash(const std::string &path) {
+  if (searching_threads_.load() > 0) return false;
+  return transposition_table_.SaveToFile(path);
+}
+
+bool Searcher::LoadHash(const std::string &path) {
+  if (searching_threads_.load() > 0) return false;
+  return transposition_table_.LoadFromFile(path);
+}
+
+std::optional<std::string> Searcher::LoadNetwork(const std::string &path) {
+  if (searching_threads_.load() > 0) return "a search is running";
+
+  const auto previous_network = nnue::shared_network;
+  if (path.empty()) {
+    nnue::LoadFromIncBin();
+  } else if (auto error = nnue::LoadFromFile(path)) {
+    return error;
+  }
+
+  // The threads still point at the previous network or at replicas of it
+  if (nnue::shared_network != previous_network && !threads_.empty()) {
+    CreateThreads(threads_.size());
+  }
+  return std::nullopt;
+}
+
+std::size_t Searcher::GetHashSize() const {
+  return transposition_table_.GetSize() * sizeof(TranspositionTableCluster) /
+         (1024 * 1024);
+}
+
+void Searcher::ClearHash() {
+  RunOnHashShares([this](int thread_idx, int thread_count) {
+    transposition_table_.Clear(thread_idx, thread_count);
+  });
+  transposition_table_.ResetEpoch();
 }
 
 }  // namespace search
@@ -1,14 +1,21 @@
 #ifndef INTEGRAL_SEARCH_H_
 #define INTEGRAL_SEARCH_H_
 
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <thread>
 
 #include "../../chess/move_gen.h"
 #include "../../utils/barrier.h"
+#include "../../utils/perf_counters.h"
 #include "../evaluation/evaluation.h"
 #include "../evaluation/nnue/accumulator.h"
+#include "abdada.h"
 #include "history/history.h"
 #include "stack.h"
+#include "stats.h"
 #include "time_mgmt.h"
 
 namespace search {
@@ -39,12 +46,9 @@ struct RootMove {
 class RootMoveList {
  public:
   explicit RootMoveList(Board &board) {
-    auto move_list = move_gen::GenerateMoves<MoveGenType::kAll>(board);
+    auto move_list = move_gen::GenerateMoves<MoveGenType::kLegalAll>(board);
     for (int i = 0; i < move_list.Size(); i++) {
-      const auto move = move_list[i];
-      if (board.IsMoveLegal(move)) {
-        list_.Push({move, 0});
-      }
+      list_.Push({move_list[i], 0});
     }
   }
 
@@ -101,14 +105,15 @@ class RootMoveList {
 };
 
 struct alignas(64) Thread {
-  explicit Thread(U32 id)
+  explicit Thread(U32 id, int numa_node = -1)
       : id(id),
+        numa_node(numa_node),
         stack({}),
         previous_score(kScoreNone),
-        nodes_searched(0),
         sel_depth(0),
-        tb_hits(0),
-        nmp_min_ply(0) {
+        nmp_min_ply(0),
+        published_nodes(0),
+        published_tb_hits(0) {
     NewGame();
   }
 
@@ -122,9 +127,13 @@ struct alignas(64) Thread {
     return id == 0;
   }
 
-  void SetBoard(Board &new_board) {
-    board = new_board;
-    board.GetAccumulator()->SetFromState(board.GetState());
+  void SetBoard(const Board &new_board) {
+    const auto start_time = std::chrono::steady_clock::now();
+    board.SetFromSnapshot(new_board);
+    stats.board_setup_nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time)
+            .count();
   }
 
   void Reset() {
@@ -134,23 +143,46 @@ struct alignas(64) Thread {
     nmp_min_ply = 0;
 
     // Reset info data
-    nodes_searched = 0;
+    stats = {};
     sel_depth = 0;
-    tb_hits = 0;
+    PublishStats();
+  }
+
+  // Counts a searched node. The first node is published right away, so that
+  // other threads can tell that the search has started
+  void CountNode() {
+    if (stats.nodes++ % kStatsPublishInterval == 0) {
+      PublishStats();
+    }
+  }
+
+  // Makes the node and table base hit counts visible to the other threads
+  void PublishStats() {
+    published_nodes.store(stats.nodes, std::memory_order_relaxed);
+    published_tb_hits.store(stats.tb_hits, std::memory_order_relaxed);
   }
 
   U32 id;
+  // Index of the NUMA node this thread is bound to, or -1 if it isn't bound
+  int numa_node;
   Board board;
   history::History history;
   Stack stack;
-  std::atomic<U64> nodes_searched;
   std::array<Score, kMaxSearchDepth + 1> scores;
   Score previous_score;
   U16 root_depth, sel_depth;
-  std::atomic<U64> tb_hits;
   int pv_move_idx;
   RootMoveList root_moves;
   U16 nmp_min_ply;
+  // Only ever accessed by this thread while it's searching
+  SearchStats stats;
+  // Copies of the counters in stats that other threads read, which are kept
+  // on their own cache line
+  alignas(64) std::atomic<U64> published_nodes;
+  std::atomic<U64> published_tb_hits;
+  // Hardware counters of this thread, which only count while it's searching
+  // once they were opened with Searcher::OpenPerfCounters()
+  perf::CounterGroup perf_counters;
 };
 
 class Searcher {
@@ -168,8 +200,21 @@ class Searcher {
 
   void Stop();
 
+  // Blocks until the search started with Start() has finished
+  void Wait();
+
   void SetThreadCount(U16 count);
 
+  // Binds search threads to NUMA nodes and gives each node its own copy of
+  // the network when enabled
+  void SetNumaAware(bool numa_aware);
+
+  // Defers moves that other threads are currently searching (ABDADA)
+  void SetAbdada(bool enabled);
+
+  // Suppresses the search info and best move output, used for benchmarking
+  void SetSilent(bool silent);
+
   void QuitThreads();
 
   void NewGame(bool clear_tables = true);
@@ -180,13 +225,61 @@ class Searcher {
 
   [[nodiscard]] U64 GetTbHits() const;
 
+  // Combined counters of all threads, which can only be read while no search
+  // is running
+  [[nodiscard]] SearchStats GetStats() const;
+
+  // Counters of each thread, with the same restriction as GetStats()
+  [[nodiscard]] std::vector<SearchStats> GetThreadStats() const;
+
+  // Opens hardware performance counters on every search thread, returning the
+  // reason why they are unavailable if a thread couldn't open any of them. The
+  // counters are closed when the thread count changes
+  [[nodiscard]] std::optional<std::string> OpenPerfCounters();
+
+  // Counts of each search thread since the last call, which can only be read
+  // while no search is running
+  [[nodiscard]] std::vector<perf::Counts> TakePerfCounts();
+
   void ResizeHash(U64 size);
 
+  [[nodiscard]] memory::PageType GetHashPageType() const;
+
+  // Writes the transposition table to a file, or replaces it with a table
+  // that was written before. The table can't be swapped out while threads are
+  // searching, so both fail if a search is running
+  [[nodiscard]] bool SaveHash(const std::string &path);
+
+  [[nodiscard]] bool LoadHash(const std::string &path);
+
+  // Size of the transposition table in megabytes
+  [[nodiscard]] std::size_t GetHashSize() const;
+
+  // Makes the network in the given file, or the embedded network if the path
+  // is empty, the one that the threads evaluate. Returns why the network
+  // couldn't be loaded, which includes a search running
+  [[nodiscard]] std::optional<std::string> LoadNetwork(const std::string &path);
+
  private:
   void Run(Thread &thread);
 
+  void CreateThreads(U16 count);
+
+  // Runs the task on every search thread and waits until all of them finished
+  void RunOnThreads(const std::function<void(Thread &)> &task);
+
   void WaitForThreads();
 
+  void SignalThreadStopped();
+
+  // Splits work on the transposition table into a share per search thread
+  void RunOnHashShares(const std::function<void(int, int)> &task);
+
+  // Physically zeroes the transposition table using the search threads
+  void ClearHash();
+
+  void ReportNumaNodes();
+
   template <SearchType type>
   void IterativeDeepening(Thread &thread);
 
@@ -211,12 +304,16 @@ class Searcher {
   TimeManagement time_mgmt_;
   std::atomic_bool stop_, quit_;
   Barrier stop_barrier_, start_barrier_, search_end_barrier_, thread_init_barrier_;
-  std::mutex stop_mutex_, thread_stopped_mutex_;
+  std::mutex stop_mutex_;
   std::atomic_int searching_threads_;
-  std::condition_variable thread_stopped_signal_;
   std::vector<std::unique_ptr<Thread>> threads_;
   std::vector<std::thread> raw_threads_;
+  const std::function<void(Thread &)> *task_ = nullptr;
+  bool numa_aware_ = false;
+  bool abdada_ = false;
+  bool silent_ = false;
   TranspositionTable transposition_table_;
+  AbdadaTable abdada_table_;
 };
 
 }  // namespace search
@@ -0,0 +1,91 @@
+#include "stats.h"
+
+#include <fmt/format.h>
+
+#include <mutex>
+
+namespace search {
+
+namespace {
+
+std::mutex last_stats_mutex;
+SearchStats last_stats;
+
+[[nodiscard]] double Percent(U64 part, U64 total) {
+  return total == 0 ? 0.0 : 100.0 * part / total;
+}
+
+}  // namespace
+
+SearchStats &SearchStats::operator+=(const SearchStats &other) {
+  nodes += other.nodes;
+  qsearch_nodes += other.qsearch_nodes;
+  tb_hits += other.tb_hits;
+  tt_hits += other.tt_hits;
+  tt_misses += other.tt_misses;
+  tt_collisions += other.tt_collisions;
+  beta_cutoffs += other.beta_cutoffs;
+  first_move_cutoffs += other.first_move_cutoffs;
+  nmp_searches += other.nmp_searches;
+  nmp_cutoffs += other.nmp_cutoffs;
+  lmr_searches += other.lmr_searches;
+  lmr_researches += other.lmr_researches;
+  probcut_searches += other.probcut_searches;
+  probcut_cutoffs += other.probcut_cutoffs;
+  singular_searches += other.singular_searches;
+  singular_extensions += other.singular_extensions;
+  accumulator_refreshes += other.accumulator_refreshes;
+  board_setup_nanoseconds += other.board_setup_nanoseconds;
+  return *this;
+}
+
+void SearchStats::Print() const {
+  const U64 tt_probes = tt_hits + tt_misses;
+  fmt::println("info string nodes {} qsearch nodes {} ({:.1f}%) tb hits {}",
+               nodes,
+               qsearch_nodes,
+               Percent(qsearch_nodes, nodes),
+               tb_hits);
+  fmt::println(
+      "info string tt probes {} hits {} ({:.1f}%) misses {} collisions {}",
+      tt_probes,
+      tt_hits,
+      Percent(tt_hits, tt_probes),
+      tt_misses,
+      tt_collisions);
+  fmt::println("info string beta cutoffs {} on first move {} ({:.1f}%)",
+               beta_cutoffs,
+               first_move_cutoffs,
+               Percent(first_move_cutoffs, beta_cutoffs));
+  fmt::println("info string nmp searches {} cutoffs {} ({:.1f}%)",
+               nmp_searches,
+               nmp_cutoffs,
+               Percent(nmp_cutoffs, nmp_searches));
+  fmt::println("info string lmr searches {} re-searches {} ({:.1f}%)",
+               lmr_searches,
+               lmr_researches,
+               Percent(lmr_researches, lmr_searches));
+  fmt::println("info string probcut searches {} cutoffs {} ({:.1f}%)",
+               probcut_searches,
+               probcut_cutoffs,
+               Percent(probcut_cutoffs, probcut_searches));
+  fmt::println("info string singular searches {} extensions {} ({:.1f}%)",
+               singular_searches,
+               singular_extensions,
+               Percent(singular_extensions, singular_searches));
+  fmt::println("info string accumulator refreshes {}", accumulator_refreshes);
+  fmt::println("info string board setup {:.1f} us over all threads",
+               board_setup_nanoseconds / 1000.0);
+}
+
+void SetLastSearchStats(const SearchStats &stats) {
+  std::lock_guard lock(last_stats_mutex);
+  last_stats = stats;
+}
+
+SearchStats GetLastSearchStats() {
+  std::lock_guard lock(last_stats_mutex);
+  return last_stats;
+}
+
+}  // namespace search
@@ -0,0 +1,49 @@
+#ifndef INTEGRAL_STATS_H
+#define INTEGRAL_STATS_H
+
+#include "../../utils/types.h"
+
+namespace search {
+
+// Number of nodes between each time a thread publishes its node and table base
+// hit counts to the other threads
+constexpr U64 kStatsPublishInterval = 1024;
+
+// Counters that are incremented throughout the search. Each thread owns its
+// counters and is the only one to write them, and they live on separate cache
+// lines so that no other thread's data gets invalidated at every node
+struct alignas(64) SearchStats {
+  U64 nodes = 0;
+  U64 qsearch_nodes = 0;
+  U64 tb_hits = 0;
+  U64 tt_hits = 0;
+  U64 tt_misses = 0;
+  // Entries rejected by probes although key bits 8 to 23 matched
+  U64 tt_collisions = 0;
+  U64 beta_cutoffs = 0;
+  U64 first_move_cutoffs = 0;
+  U64 nmp_searches = 0;
+  U64 nmp_cutoffs = 0;
+  U64 lmr_searches = 0;
+  U64 lmr_researches = 0;
+  U64 probcut_searches = 0;
+  U64 probcut_cutoffs = 0;
+  U64 singular_searches = 0;
+  U64 singular_extensions = 0;
+  U64 accumulator_refreshes = 0;
+  // Time spent copying the position into the thread's board before searching
+  U64 board_setup_nanoseconds = 0;
+
+  SearchStats &operator+=(const SearchStats &other);
+
+  void Print() const;
+};
+
+// The combined counters of all threads from the most recent search or bench
+void SetLastSearchStats(const SearchStats &stats);
+
+[[nodiscard]] SearchStats GetLastSearchStats();
+
+}  // namespace search
+
+#endif  // INTEGRAL_STATS_H
@@ -59,8 +59,8 @@ int NodeLimiter::GetSearchDepth() const {
 }
 
 bool NodeLimiter::ShouldStop(Move best_move, int depth, Thread& thread) {
-  return soft_max_nodes_ != 0 && thread.nodes_searched >= soft_max_nodes_ ||
-         TimesUp(thread.nodes_searched);
+  return soft_max_nodes_ != 0 && thread.stats.nodes >= soft_max_nodes_ ||
+         TimesUp(thread.stats.nodes);
 }
 
 bool NodeLimiter::TimesUp(U64 nodes_searched) {
@@ -97,7 +97,7 @@ U64& TimedLimiter::NodesSpent(Move move) {
 
 bool TimedLimiter::ShouldStop(Move best_move, int depth, Thread& thread) {
   if (move_time_ != 0) {
-    return TimesUp(thread.nodes_searched);
+    return TimesUp(thread.stats.nodes);
   }
 
   if (depth <= 5) {
@@ -134,7 +134,7 @@ bool TimedLimiter::ShouldStop(Move best_move, int depth, Thread& thread) {
 
   const auto best_move_nodes = NodesSpent(best_move);
   const auto percent_nodes_not_best =
-      1.0 - static_cast<double>(best_move_nodes) / thread.nodes_searched;
+      1.0 - static_cast<double>(best_move_nodes) / thread.stats.nodes;
   const double node_count_factor = std::max<double>(
       kNodeFactorBase,
       percent_nodes_not_best * kNodeFactorSlope + kNodeFactorIntercept);
@@ -164,7 +164,9 @@ void TimedLimiter::CalculateLimits() {
   const int overhead = uci::listener.GetOption("MoveOverhead").GetValue<int>();
 
   if (move_time_ != 0) {
-    hard_limit_ = move_time_ - overhead;
+    // A move time below the overhead would otherwise wrap around when
+    // compared against the elapsed time and never stop the search
+    hard_limit_ = std::max(1, move_time_ - overhead);
     return;
   }
 
@@ -1,66 +1,197 @@
 #include "transpo.h"
 
-#include <thread>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <utility>
 
+#include "../../../shared/simd.h"
 #include "../evaluation/evaluation.h"
 
 namespace search {
 
-[[nodiscard]] TranspositionTableEntry *TranspositionTable::Probe(
+namespace {
+
+[[nodiscard]] TranspositionTableEntry Unpack(U64 data) {
+  return std::bit_cast<TranspositionTableEntry>(data);
+}
+
+[[nodiscard]] U64 Pack(const TranspositionTableEntry &entry) {
+  return std::bit_cast<U64>(entry);
+}
+
+// Computes the check word of an entry, which holds the key XOR'd with the data
+// in its upper bits and the epoch that the entry was written in in its lowest
+// byte
+[[nodiscard]] U64 CheckWord(U64 key, U64 data, U8 epoch) {
+  return ((key ^ data) & ~kTTEpochMask) | epoch;
+}
+
+// The words of a cluster as they were read at one point. Every entry is
+// verified and unpacked from the same copy, so that a concurrent write can't
+// slip in between the two
+struct ClusterWords {
+  alignas(32) std::array<U64, kTTClusterSize> checks;
+  alignas(32) std::array<U64, kTTClusterSize> data;
+};
+
+[[nodiscard]] U64 Load(const std::atomic<U64> &word) {
+  return word.load(std::memory_order_relaxed);
+}
+
+void Store(std::atomic<U64> &word, U64 value) {
+  word.store(value, std::memory_order_relaxed);
+}
+
+[[nodiscard]] ClusterWords LoadCluster(
+    const TranspositionTableCluster &cluster) {
+  ClusterWords words;
+  for (int i = 0; i < kTTClusterSize; i++) {
+    words.checks[i] = Load(cluster.checks[i]);
+    words.data[i] = Load(cluster.data[i]);
+  }
+  return words;
+}
+
+// Returns a mask with the bit of each entry that belongs to the key set
+[[nodiscard]] int MatchKey(const ClusterWords &words,
+                           const U64 &key,
+                           U8 epoch) {
+#if BUILD_HAS_AVX2
+  static_assert(kTTClusterSize == 4);
+  const auto checks = _mm256_load_si256(
+      reinterpret_cast<const __m256i *>(words.checks.data()));
+  const auto data =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(words.data.data()));
+  const auto expected_checks = _mm256_or_si256(
+      _mm256_and_si256(
+          _mm256_xor_si256(data, _mm256_set1_epi64x(static_cast<I64>(key))),
+          _mm256_set1_epi64x(static_cast<I64>(~kTTEpochMask))),
+      _mm256_set1_epi64x(epoch));
+  const auto matches = _mm256_cmpeq_epi64(checks, expected_checks);
+  return _mm256_movemask_pd(_mm256_castsi256_pd(matches));
+#else
+  int mask = 0;
+  for (int i = 0; i < kTTClusterSize; i++) {
+    mask |= (words.checks[i] == CheckWord(key, words.data[i], epoch)) << i;
+  }
+  return mask;
+#endif
+}
+
+constexpr std::array<char, 8> kTTFileMagic = {
+    'I', 'N', 'T', 'G', 'R', 'L', 'T', 'T'};
+constexpr U32 kTTFileVersion = 1;
+
+// The clusters start one page into the file, so that mapping the file keeps
+// them aligned to a cache line
+constexpr std::size_t kTTFileHeaderSize = 4096;
+
+struct TranspositionTableFileHeader {
+  std::array<char, 8> magic;
+  U32 version;
+  U32 cluster_size;
+  U64 cluster_count;
+  I32 age;
+  U8 epoch;
+};
+
+static_assert(sizeof(TranspositionTableFileHeader) <= kTTFileHeaderSize);
+
+// Returns the range of clusters that a thread is responsible for when work on
+// the table is split across threads
+[[nodiscard]] std::pair<std::size_t, std::size_t> ThreadShare(
+    std::size_t table_size, int thread_idx, int thread_count) {
+  const std::size_t chunks = (table_size + thread_count - 1) / thread_count;
+  const std::size_t start = std::min(chunks * thread_idx, table_size);
+  return {start, std::min(chunks, table_size - start)};
+}
+
+}  // namespace
+
+[[nodiscard]] TranspositionTableProbe TranspositionTable::Probe(
     const U64 &key) {
   auto &cluster = (*this)[key];
+  const auto words = LoadCluster(cluster);
+
+  if (const int matches = MatchKey(words, key, epoch_)) {
+    const int index = std::countr_zero(static_cast<unsigned>(matches));
+    return {Unpack(words.data[index]), &cluster, index, true, 0};
+  }
+
   // Default to replacing the first entry (if it's available)
-  auto replace_entry = &cluster.entries[0];
-  // Find another entry if the first one is already taken
-  if (replace_entry->key != 0 && !replace_entry->CompareKey(key)) {
-    for (int i = 1; i < kTTClusterSize; i++) {
-      const auto entry = &cluster.entries[i];
-      // If this entry is available, we can attempt to write to it
-      if (entry->key == 0 || entry->CompareKey(key)) {
-        return entry;
-      }
-      // Always prefer the lowest quality entry
-      const int lowest_quality =
-          replace_entry->depth - 8 * GetAgeDelta(replace_entry);
-      const int current_quality = entry->depth - 8 * GetAgeDelta(entry);
-      if (lowest_quality > current_quality) {
-        replace_entry = entry;
-      }
+  int replace_index = 0;
+  int lowest_quality = std::numeric_limits<int>::max();
+  int collisions = 0;
+  for (int i = 0; i < kTTClusterSize; i++) {
+    const U64 check = words.checks[i], data = words.data[i];
+
+    // Entries written before the table was last cleared are available, so we
+    // can attempt to write to them
+    if ((check & kTTEpochMask) != epoch_) {
+      replace_index = i;
+      break;
+    }
+
+    // The entry would have passed as a hit with a 16-bit key
+    constexpr U64 kCollisionMask = 0xFFFFULL << 8;
+    collisions += ((check ^ data ^ key) & kCollisionMask) == 0;
+
+    // Always prefer the lowest quality entry
+    const auto entry = Unpack(data);
+    const int quality = entry.depth - 8 * GetAgeDelta(entry);
+    if (quality < lowest_quality) {
+      lowest_quality = quality;
+      replace_index = i;
     }
   }
 
-  return replace_entry;
+  return {TranspositionTableEntry(),
+          &cluster,
+          replace_index,
+          false,
+          collisions};
 }
 
-void TranspositionTable::Save(TranspositionTableEntry *old_entry,
+void TranspositionTable::Save(const TranspositionTableProbe &probe,
                               TranspositionTableEntry new_entry,
                               const U64 &key,
                               I32 ply,
                               bool in_pv) {
-  if (new_entry.move || !old_entry->CompareKey(key)) {
-    old_entry->move = new_entry.move;
-  }
+  auto &cluster = *probe.cluster;
+  auto &check = cluster.checks[probe.index];
+  auto &data = cluster.data[probe.index];
 
-  if (!old_entry->CompareKey(key) ||
-      new_entry.flag == TranspositionTableEntry::kExact ||
-      new_entry.depth + 3 + 2 * in_pv >= old_entry->depth ||
-      old_entry->age != age_) {
-    new_entry.age = age_;
+  // Read the slot again, since it could have been overwritten since probing
+  const U64 old_data = Load(data);
+  const bool same_key = Load(check) == CheckWord(key, old_data, epoch_);
+  auto old_entry = Unpack(old_data);
+
+  if (new_entry.move || !same_key) {
+    old_entry.move = new_entry.move;
+  }
 
-    old_entry->key = static_cast<U16>(key);
-    old_entry->score =
+  if (!same_key || new_entry.flag == TranspositionTableEntry::kExact ||
+      new_entry.depth + 3 + 2 * in_pv >= old_entry.depth ||
+      old_entry.age != age_) {
+    old_entry.score =
         TranspositionTableEntry::CorrectScore(new_entry.score, -ply);
-    old_entry->depth = new_entry.depth;
-    old_entry->age = new_entry.age;
-    old_entry->flag = new_entry.flag;
-    old_entry->was_in_pv = new_entry.was_in_pv;
-    old_entry->static_eval = new_entry.static_eval;
+    old_entry.depth = new_entry.depth;
+    old_entry.age = age_;
+    old_entry.flag = new_entry.flag;
+    old_entry.was_in_pv = new_entry.was_in_pv;
+    old_entry.static_eval = new_entry.static_eval;
   }
+
+  const U64 new_data = Pack(old_entry);
+  Store(data, new_data);
+  Store(check, CheckWord(key, new_data, epoch_));
 }
 
 U32 TranspositionTable::GetAgeDelta(
-    const TranspositionTableEntry *entry) const {
-  return (kMaxTTAge + age_ - entry->age) % kMaxTTAge;
+    const TranspositionTableEntry &entry) const {
+  return (kMaxTTAge + age_ - entry.age) % kMaxTTAge;
 }
 
 void TranspositionTable::Age() {
@@ -70,34 +201,163 @@ void TranspositionTable::Age() {
 int TranspositionTable::HashFull() const {
   int count = 0;
   for (int i = 0; i < 1000; i++) {
-    count +=
-        std::ranges::count_if(table_[i].entries, [this](const auto &entry) {
-          return entry.age == age_ && entry.key != 0 &&
-                 entry.score != kScoreNone;
-        });
+    const auto &cluster = table_[i];
+    for (int j = 0; j < kTTClusterSize; j++) {
+      const auto entry = Unpack(Load(cluster.data[j]));
+      count += (Load(cluster.checks[j]) & kTTEpochMask) == epoch_ &&
+               entry.age == age_ && entry.score != kScoreNone;
+    }
   }
   return count / kTTClusterSize;
 }
 
-void TranspositionTable::Clear(int num_threads) {
-  const std::size_t chunks = (table_size_ + num_threads - 1) / num_threads;
+bool TranspositionTable::NewEpoch() {
+  age_ = 0;
 
-  std::vector<std::thread> threads;
-  for (int i = 0; i < num_threads; ++i) {
-    threads.emplace_back([i, chunks, this]() {
-      const std::size_t clear_index = chunks * i;
-      const std::size_t clear_size =
-          std::min(chunks, table_size_ - clear_index) *
-          sizeof(TranspositionTableCluster);
-      std::memset(table_ + clear_index, 0, clear_size);
-    });
+  if (epoch_ < kMaxTTEpoch) {
+    epoch_++;
+    return true;
   }
 
-  for (auto &thread : threads) {
-    thread.join();
-  }
+  // Reusing the first epoch would bring back entries from long ago, so the
+  // table has to be cleared physically instead
+  epoch_ = 1;
+  return false;
+}
 
+void TranspositionTable::Clear(int thread_idx, int thread_count) {
+  const auto [clear_index, clear_size] =
+      ThreadShare(table_size_, thread_idx, thread_count);
+  std::memset(table_ + clear_index,
+              0,
+              clear_size * sizeof(TranspositionTableCluster));
+}
+
+void TranspositionTable::ResetEpoch() {
+  epoch_ = 1;
   age_ = 0;
 }
 
-}  // namespace search
\ No newline at end of file
+void TranspositionTable::BeginResize(std::size_t mb_size) {
+  old_allocation_ = std::exchange(allocation_, {});
+  old_table_ = table_;
+  old_table_size_ = table_size_;
+  Resize(mb_size);
+}
+
+U64 TranspositionTable::Migrate(int thread_idx, int thread_count) {
+  const auto [start, size] =
+      ThreadShare(old_table_size_, thread_idx, thread_count);
+
+  U64 migrated = 0;
+  for (std::size_t i = start; i < start + size; i++) {
+    const auto &old_cluster = old_table_[i];
+    for (int j = 0; j < kTTClusterSize; j++) {
+      const U64 old_check = Load(old_cluster.checks[j]);
+      const U64 old_data = Load(old_cluster.data[j]);
+      if ((old_check & kTTEpochMask) != epoch_) continue;
+
+      // Only the upper bits of the key can be recovered from the check word,
+      // but the index is derived from the upper bits of the key, so the entry
+      // almost always lands in the cluster that probes will look at
+      const U64 key = (old_check ^ old_data) & ~kTTEpochMask;
+      auto &cluster = (*this)[key];
+
+      // Prefer an empty slot, otherwise replace the lowest quality entry so
+      // that the most valuable entries survive when the table shrinks
+      int replace_index = 0;
+      int lowest_quality = std::numeric_limits<int>::max();
+      for (int k = 0; k < kTTClusterSize; k++) {
+        if ((Load(cluster.checks[k]) & kTTEpochMask) != epoch_) {
+          replace_index = k;
+          lowest_quality = std::numeric_limits<int>::min();
+          break;
+        }
+
+        const auto entry = Unpack(Load(cluster.data[k]));
+        const int quality = entry.depth - 8 * GetAgeDelta(entry);
+        if (quality < lowest_quality) {
+          lowest_quality = quality;
+          replace_index = k;
+        }
+      }
+
+      const auto old_entry = Unpack(old_data);
+      if (old_entry.depth - 8 * static_cast<int>(GetAgeDelta(old_entry)) <
+          lowest_quality) {
+        continue;
+      }
+
+      // Other threads may be migrating into the same cluster, but a torn
+      // write only fails verification like it does during search
+      Store(cluster.data[replace_index], old_data);
+      Store(cluster.checks[replace_index], old_check);
+      migrated++;
+    }
+  }
+
+  return migrated;
+}
+
+void TranspositionTable::FinishResize() {
+  memory::FreeLargePages(old_allocation_);
+  old_allocation_ = {};
+  old_table_ = nullptr;
+  old_table_size_ = 0;
+}
+
+bool TranspositionTable::SaveToFile(const std::string &path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) return false;
+
+  std::array<char, kTTFileHeaderSize> header_bytes{};
+  const TranspositionTableFileHeader header{
+      kTTFileMagic,
+      kTTFileVersion,
+      sizeof(TranspositionTableCluster),
+      table_size_,
+      age_,
+      epoch_,
+  };
+  std::memcpy(header_bytes.data(), &header, sizeof(header));
+
+  file.write(header_bytes.data(), header_bytes.size());
+  file.write(reinterpret_cast<const char *>(table_),
+             static_cast<std::streamsize>(table_size_ *
+                                          sizeof(TranspositionTableCluster)));
+  return static_cast<bool>(file.flush());
+}
+
+bool TranspositionTable::LoadFromFile(const std::string &path) {
+  TranspositionTableFileHeader header{};
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file ||
+        !file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+      return false;
+    }
+  }
+
+  if (header.magic != kTTFileMagic || header.version != kTTFileVersion ||
+      header.cluster_size != sizeof(TranspositionTableCluster) ||
+      header.cluster_count == 0 || header.epoch == 0 ||
+      header.age < 0 || header.age >= kMaxTTAge) {
+    return false;
+  }
+
+  // Reject truncated files before the current table is given up
+  std::error_code error;
+  const auto file_size = std::filesystem::file_size(path, error);
+  const auto table_bytes =
+      header.cluster_count * sizeof(TranspositionTableCluster);
+  if (error || file_size < kTTFileHeaderSize + table_bytes) return false;
+
+  if (!MapFile(path, kTTFileHeaderSize)) return false;
+
+  table_size_ = header.cluster_count;
+  age_ = header.age;
+  epoch_ = header.epoch;
+  return true;
+}
+
+}  // namespace search
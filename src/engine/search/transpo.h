@@ -2,8 +2,11 @@
 #define INTEGRAL_TRANSPO_H_
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <cstddef>
+#include <string>
 
 #include "../../chess/move.h"
 #include "../../utils/hash_table.h"
@@ -19,37 +22,28 @@ struct TranspositionTableEntry {
   };
 
   TranspositionTableEntry()
-      : key(0),
-        depth(0),
-        score(kScoreNone),
+      : score(kScoreNone),
         static_eval(0),
         move(Move::NullMove()),
+        depth(0),
         age(0),
         was_in_pv(false),
         flag(kNone) {}
 
-  explicit TranspositionTableEntry(U64 key,
-                                   U8 depth,
+  explicit TranspositionTableEntry(U8 depth,
                                    Flag flag,
                                    Score score,
                                    Score static_eval,
                                    Move move,
                                    bool was_in_pv)
-      : key(static_cast<U16>(key)),
-        depth(depth),
-        score(score),
+      : score(score),
         static_eval(static_eval),
         move(move),
+        depth(depth),
         age(0),
         was_in_pv(was_in_pv),
         flag(flag) {}
 
-  // Keys are packed to maximize the number of entries the table can hold
-  // Therefore, we must down-cast when checking for key equality
-  [[nodiscard]] bool CompareKey(const U64 &test_key) const {
-    return static_cast<U16>(test_key) == key;
-  }
-
   // Check if the entry's score falls within the search window
   [[nodiscard]] bool CanUseScore(Score alpha, Score beta) const {
     return score != kScoreNone &&
@@ -67,7 +61,6 @@ struct TranspositionTableEntry {
     return score;
   }
 
-  U16 key;
   I16 score, static_eval;
   Move move;
   U8 depth;
@@ -81,27 +74,58 @@ struct TranspositionTableEntry {
   };
 };
 
-static_assert(sizeof(TranspositionTableEntry) == 10);
-
-constexpr int kTTClusterSize = 3;
+// Entries are packed into a single 64-bit data word
+static_assert(sizeof(TranspositionTableEntry) == sizeof(U64));
+
+constexpr int kTTClusterSize = 4;
+
+// Each entry is stored as its data word along with a check word, which is the
+// position key XOR'd with the data. An entry that was torn by concurrent
+// writers or belongs to another position fails verification and is treated
+// as a miss, so the table needs no locks. The lowest byte of the check word is
+// replaced by the epoch the entry was written in, which allows the table to be
+// emptied by simply starting a new epoch. The check and data words are kept in
+// separate arrays so that a cluster fills exactly one cache line and all of
+// its keys can be verified at once. Threads access the words with relaxed
+// atomics, since verification already catches any interleaving of writes
+struct alignas(64) TranspositionTableCluster {
+  std::array<std::atomic<U64>, kTTClusterSize> checks;
+  std::array<std::atomic<U64>, kTTClusterSize> data;
+};
 
-struct TranspositionTableCluster {
-  std::array<TranspositionTableEntry, kTTClusterSize> entries;
-  U16 padding;
+static_assert(std::atomic<U64>::is_always_lock_free);
+
+static_assert(sizeof(TranspositionTableCluster) == 64);
+
+// A copy of the entry found for a position along with the slot it was read
+// from, which is where the position will be saved to
+struct TranspositionTableProbe {
+  TranspositionTableEntry entry;
+  TranspositionTableCluster *cluster;
+  int index;
+  bool hit;
+  // Number of entries that were rejected although key bits 8 to 23 matched,
+  // which are either torn entries or collisions that a 16-bit key would have
+  // let through
+  int collisions;
 };
 
 constexpr int kMaxTTAge = 32;
 
+constexpr U64 kTTEpochMask = 0xFF;
+// Epoch 0 is never used, so that zeroed clusters are always empty
+constexpr U8 kMaxTTEpoch = 0xFF;
+
 class TranspositionTable : public AlignedHashTable<TranspositionTableCluster> {
  public:
   explicit TranspositionTable(std::size_t mb_size)
-      : AlignedHashTable(mb_size), age_(0) {}
+      : AlignedHashTable(mb_size), age_(0), epoch_(1) {}
 
-  TranspositionTable() : age_(0) {}
+  TranspositionTable() : age_(0), epoch_(1) {}
 
-  [[nodiscard]] TranspositionTableEntry *Probe(const U64 &key);
+  [[nodiscard]] TranspositionTableProbe Probe(const U64 &key);
 
-  void Save(TranspositionTableEntry *old_entry,
+  void Save(const TranspositionTableProbe &probe,
             TranspositionTableEntry new_entry,
             const U64 &key,
             I32 ply,
@@ -111,13 +135,48 @@ class TranspositionTable : public AlignedHashTable<TranspositionTableCluster> {
 
   [[nodiscard]] int HashFull() const;
 
-  void Clear(int num_threads);
+  // Logically empties the table in constant time by starting a new epoch,
+  // since entries from previous epochs never match. Returns false if the
+  // epoch counter wrapped around, in which case the table must be cleared
+  // physically with Clear()
+  [[nodiscard]] bool NewEpoch();
+
+  // Zeroes this thread's share of the table, which lets clearing be split
+  // across the search threads. ResetEpoch() must be called once all of the
+  // shares are cleared
+  void Clear(int thread_idx, int thread_count);
+
+  void ResetEpoch();
+
+  // Allocates a table of the new size while keeping the old clusters around,
+  // so that their entries can be moved over with Migrate() once every share
+  // of the new table was cleared. FinishResize() releases the old clusters
+  void BeginResize(std::size_t mb_size);
+
+  // Moves the live entries from this thread's share of the old clusters into
+  // the new table, returning how many entries were moved
+  U64 Migrate(int thread_idx, int thread_count);
+
+  void FinishResize();
+
+  // Writes the table to a file along with the current age and epoch, so that
+  // it can be reused in a later session
+  [[nodiscard]] bool SaveToFile(const std::string &path) const;
+
+  // Replaces the table with a private mapping of a file written by
+  // SaveToFile(). Entries are only read from disk once they are first probed,
+  // so loading is instant regardless of the table size
+  [[nodiscard]] bool LoadFromFile(const std::string &path);
 
  private:
-  [[nodiscard]] U32 GetAgeDelta(const TranspositionTableEntry *entry) const;
+  [[nodiscard]] U32 GetAgeDelta(const TranspositionTableEntry &entry) const;
 
  private:
   int age_;
+  U8 epoch_;
+  memory::LargePageAllocation old_allocation_;
+  TranspositionTableCluster *old_table_ = nullptr;
+  std::size_t old_table_size_ = 0;
 };
 
 }  // namespace search
@@ -72,6 +72,12 @@ class Option {
     callback_(*this);
   }
 
+  // Changes the value without calling the callback, for settings that the
+  // engine changed by itself and that only have to be reflected here
+  void UpdateValue(std::string_view value) {
+    value_ = value;
+  }
+
   template <typename T>
   [[nodiscard]] T GetValue() const {
     if constexpr (std::is_same<T, bool>::value) {
@@ -5,6 +5,7 @@
 #include "../../ascii_logo.h"
 #include "../../data_gen/data_gen.h"
 #include "../../tests/tests.h"
+#include "../evaluation/nnue/nnue.h"
 #include "../evaluation/nnue/sparse.h"
 #include "../search/search.h"
 #include "../search/syzygy/syzygy.h"
@@ -13,26 +14,61 @@
 
 namespace uci {
 
+namespace {
+
+// The exit code of the process when it runs a command from the command line,
+// which is set when the command fails (such as a bench comparison that found a
+// regression) so that scripts don't have to parse the output
+int exit_code = 0;
+
+// Options call their callbacks once when they are added, which mustn't print
+// anything since scripts and OpenBench parse the output of commands like bench
+bool options_initialized = false;
+
+}  // namespace
+
 namespace options {
 
 void Initialize(search::Searcher &searcher) {
   // clang-format off
   listener.AddOption<OptionVisibility::kPublic>("Hash", 64, 1, 1048576, [&searcher](const Option &option) {
     searcher.ResizeHash(option.GetValue<int>());
+    if (options_initialized) {
+      fmt::println("info string Hash {} MB allocated with {}",
+                   option.GetValue<int>(),
+                   memory::PageTypeName(searcher.GetHashPageType()));
+    }
   });
   listener.AddOption<OptionVisibility::kPublic>("Threads", 1, 1, 512, [&searcher](const Option &option) {
     searcher.SetThreadCount(option.GetValue<U16>());
   });
+  listener.AddOption<OptionVisibility::kPublic>("NumaAware", false, [&searcher](const Option &option) {
+    searcher.SetNumaAware(option.GetValue<bool>());
+  });
+  listener.AddOption<OptionVisibility::kPublic>("ABDADA", false, [&searcher](const Option &option) {
+    searcher.SetAbdada(option.GetValue<bool>());
+  });
   listener.AddOption<OptionVisibility::kPublic>("MultiPV", 1, 1, 6);
   listener.AddOption<OptionVisibility::kPublic>("MoveOverhead", 10, 0, 10000);
   listener.AddOption<OptionVisibility::kPublic>("Minimal", false);
   listener.AddOption<OptionVisibility::kPublic>("SyzygyPath", std::string("<empty>"), [](const Option &option) {
     syzygy::SetPath(option.GetValue<std::string>());
   });
+  listener.AddOption<OptionVisibility::kPublic>("EvalFile", std::string("<empty>"), [&searcher](const Option &option) {
+    const auto path = option.GetValue<std::string>();
+    const bool embedded = path == "<empty>";
+    if (const auto error = searcher.LoadNetwork(embedded ? "" : path)) {
+      fmt::println("info string Failed to load network from {}: {}", path, *error);
+    } else if (!embedded) {
+      fmt::println("info string Network loaded from {}", path);
+    }
+  });
   listener.AddOption<OptionVisibility::kPublic>("SyzygyProbeDepth", 1, 1, 100, [](const Option &option) {
     syzygy::probe_depth = option.GetValue<int>();
   });
   // clang-format on
+
+  options_initialized = true;
 }
 
 }  // namespace options
@@ -66,6 +102,7 @@ void Initialize(Board &board, search::Searcher &searcher) {  // clang-format off
 
   listener.RegisterCommand("go", CommandType::kUnordered, {
     CreateArgument("perft", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("hash", ArgumentType::kOptional, LimitedInputProcessor<1>()),
     CreateArgument("infinite", ArgumentType::kOptional, NoInputProcessor()),
     CreateArgument("movetime", ArgumentType::kOptional, LimitedInputProcessor<1>()),
     CreateArgument("depth", ArgumentType::kOptional, LimitedInputProcessor<1>()),
@@ -78,7 +115,10 @@ void Initialize(Board &board, search::Searcher &searcher) {  // clang-format off
   }, [&board, &searcher](Command *cmd) {
     const auto perft_depth = cmd->ParseArgument<int>("perft");
     if (perft_depth) {
-      tests::Perft(board, *perft_depth);
+      tests::Perft(board,
+                   *perft_depth,
+                   listener.GetOption("Threads").GetValue<int>(),
+                   cmd->ParseArgument<int>("hash").value_or(tests::kDefaultPerftHash));
       return;
     }
 
@@ -158,6 +198,40 @@ void Initialize(Board &board, search::Searcher &searcher) {  // clang-format off
     searcher.NewGame();
   });
 
+  listener.RegisterCommand("hash", CommandType::kUnordered, {
+    CreateArgument("save", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("load", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+  }, [&searcher](Command *cmd) {
+    if (const auto path = cmd->ParseArgument<std::string>("save")) {
+      if (searcher.SaveHash(*path)) fmt::println("info string Hash saved to {}", *path);
+      else fmt::println("info string Failed to save hash to {}", *path);
+    } else if (const auto path = cmd->ParseArgument<std::string>("load")) {
+      if (searcher.LoadHash(*path)) {
+        // The table takes the size of the one in the file
+        const auto hash_size = std::max<std::size_t>(searcher.GetHashSize(), 1);
+        listener.GetOption("Hash").UpdateValue(std::to_string(hash_size));
+        fmt::println("info string Hash {} MB loaded from {}", searcher.GetHashSize(), *path);
+      } else {
+        fmt::println("info string Failed to load hash from {}", *path);
+      }
+    } else {
+      fmt::println("info string Usage: hash save <path> | hash load <path>");
+    }
+  });
+
+  listener.RegisterCommand("network", CommandType::kUnordered, {
+    CreateArgument("save", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+  }, [](Command *cmd) {
+    if (const auto path = cmd->ParseArgument<std::string>("save")) {
+      if (nnue::SaveToFile(*path)) fmt::println("info string Network saved to {}", *path);
+      else fmt::println("info string Failed to save network to {}", *path);
+    }
+  });
+
+  listener.RegisterCommand("stats", CommandType::kUnordered, {}, [](Command *cmd) {
+    search::GetLastSearchStats().Print();
+  });
+
   listener.RegisterCommand("eval", CommandType::kUnordered, {}, [&board](Command *cmd) {
     const auto eval = eval::Evaluate(board);
     fmt::println("info cp {}\ninfo normalized cp {}", eval, eval::NormalizeScore(eval, board.GetState().MaterialCount()));
@@ -180,21 +254,58 @@ void Initialize(Board &board, search::Searcher &searcher) {  // clang-format off
   listener.RegisterCommand("test", CommandType::kUnordered, {
     CreateArgument("see", ArgumentType::kOptional, NoInputProcessor()),
     CreateArgument("perft", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("hash", ArgumentType::kOptional, LimitedInputProcessor<1>()),
   }, [](Command *cmd) {
+    const auto threads = listener.GetOption("Threads").GetValue<int>();
+    const auto hash = cmd->ParseArgument<int>("hash").value_or(tests::kDefaultPerftHash);
     if (cmd->ArgumentExists("see")) tests::SEESuite();
-    else if (cmd->ArgumentExists("perft")) tests::PerftSuite();
+    else if (cmd->ArgumentExists("perft")) tests::PerftSuite(threads, hash);
     else {
       tests::SEESuite();
-      tests::PerftSuite();
+      tests::PerftSuite(threads, hash);
     }
   });
 
   listener.RegisterCommand("bench", CommandType::kUnordered, {
-    CreateArgument("depth", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("depth", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("threads", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("hash", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("movetime", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("reps", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("abdada", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("latency", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("counters", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("json", ArgumentType::kOptional, NoInputProcessor()),
+    CreateArgument("out", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("compare", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+    CreateArgument("runs", ArgumentType::kOptional, LimitedInputProcessor<1>()),
+  }, [](Command *cmd) {
+    const auto bench_depth = cmd->ParseArgument<int>("depth").value_or(tests::kDefaultBenchDepth);
+    const auto threads = cmd->ParseArgument<int>("threads");
+    const auto hash = cmd->ParseArgument<int>("hash").value_or(64);
+    const auto runs = cmd->ParseArgument<int>("runs");
+    if (const auto baseline = cmd->ParseArgument<std::string>("compare")) {
+      if (!tests::BenchCompareSuite(*baseline, std::max(1, runs.value_or(5)))) exit_code = 1;
+    } else if (cmd->ArgumentExists("json")) {
+      tests::BenchJsonSuite(bench_depth, std::max(1, runs.value_or(1)), cmd->ParseArgument<std::string>("out").value_or(""));
+    } else if (cmd->ArgumentExists("latency")) tests::LatencyBenchSuite(threads.value_or(1));
+    else if (cmd->ArgumentExists("counters")) tests::PerfBenchSuite(bench_depth, threads.value_or(1), hash);
+    else if (cmd->ArgumentExists("abdada")) tests::SmpBenchSuite(bench_depth, threads.value_or(1), hash);
+    else if (threads || cmd->ArgumentExists("movetime")) {
+      tests::ScalingBenchSuite({
+        .depth = bench_depth,
+        .move_time = cmd->ParseArgument<int>("movetime").value_or(0),
+        .max_threads = threads.value_or(1),
+        .hash = hash,
+        .repetitions = std::max(1, cmd->ParseArgument<int>("reps").value_or(3)),
+      });
+    } else tests::BenchSuite(bench_depth);
+  });
+
+  listener.RegisterCommand("startup-profile", CommandType::kUnordered, {
+    CreateArgument("runs", ArgumentType::kOptional, LimitedInputProcessor<1>()),
   }, [](Command *cmd) {
-    const auto bench_depth = cmd->ParseArgument<int>("depth");
-    if (bench_depth) tests::BenchSuite(*bench_depth);
-    else tests::BenchSuite(tests::kDefaultBenchDepth);
+    tests::StartupProfile(std::max(1, cmd->ParseArgument<int>("runs").value_or(10)));
   });
 
 #ifdef SPARSE_PERMUTE
@@ -236,7 +347,7 @@ Listener::~Listener() {
   }
 }
 
-void AcceptCommands(int arg_count, char **args) {
+int AcceptCommands(int arg_count, char **args) {
   Board board;
   board.SetFromFen(fen::kStartFen);
 
@@ -244,13 +355,35 @@ void AcceptCommands(int arg_count, char **args) {
 
   options::Initialize(searcher);
   commands::Initialize(board, searcher);
+  tests::ReportStartupIfProfiled("initialized");
+
+  // Passes the command line on as a regular command
+  const auto execute_arguments = [&]() {
+    std::string line;
+    for (int i = 1; i < arg_count; i++) {
+      line += std::string(args[i]) + ' ';
+    }
+    listener.ExecuteLine(line);
+  };
 
   // OpenBench requires the bench command to be parsed from the command line
   if (args[1] && std::string(args[1]) == "bench") {
-    const int depth =
-        arg_count == 3 ? std::stoi(args[2]) : tests::kDefaultBenchDepth;
-    tests::BenchSuite(depth);
-    return;
+    if (arg_count <= 3) {
+      const int depth =
+          arg_count == 3 ? std::stoi(args[2]) : tests::kDefaultBenchDepth;
+      tests::BenchSuite(depth);
+      return 0;
+    }
+
+    // Other bench modes (such as "bench compare base.json") are passed on as
+    // a regular command
+    execute_arguments();
+    return exit_code;
+  }
+
+  if (args[1] && std::string(args[1]) == "startup-profile") {
+    execute_arguments();
+    return exit_code;
   }
 
   PrintAsciiLogo();
@@ -258,6 +391,7 @@ void AcceptCommands(int arg_count, char **args) {
       "    {} by {}\n", constants::kEngineName, constants::kEngineAuthor);
 
   listener.Listen();
+  return 0;
 }
 
 }  // namespace uci
\ No newline at end of file
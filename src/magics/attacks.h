@@ -1,36 +1,192 @@
 #ifndef INTEGRAL_MAGICS_ATTACKS_H_
 #define INTEGRAL_MAGICS_ATTACKS_H_
 
-#include "../../shared/multi_array.h"
+#include <array>
+#include <vector>
+
 #include "../chess/bitboard.h"
+#include "precomputed.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace magics::attacks {
 
-constexpr int kBishopBlockerCombinations = 512;
-constexpr int kRookBlockerCombinations = 4096;
+template <Direction Dir>
+constexpr int DistanceToEdge(Square square) {
+  if constexpr (Dir == Direction::kEast) {
+    return 7 - square.File();
+  } else if constexpr (Dir == Direction::kNorth) {
+    return 7 - square.Rank();
+  } else if constexpr (Dir == Direction::kWest) {
+    return square.File();
+  } else if constexpr (Dir == Direction::kSouth) {
+    return square.Rank();
+  } else if constexpr (Dir == Direction::kNorthEast) {
+    return std::min(7 - square.Rank(), 7 - square.File());
+  } else if constexpr (Dir == Direction::kNorthWest) {
+    return std::min(7 - square.Rank(), square.File());
+  } else if constexpr (Dir == Direction::kSouthEast) {
+    return std::min(square.Rank(), 7 - square.File());
+  } else if constexpr (Dir == Direction::kSouthWest) {
+    return std::min(square.Rank(), square.File());
+  } else {
+    return 0;  // This line will never be reached, it's just to satisfy the
+               // compiler
+  }
+}
+
+template <Direction dir>
+constexpr BitBoard SlidingAttacks(U8 from, const BitBoard& occupied) {
+  BitBoard attacks;
+  BitBoard current = BitBoard::FromSquare(from);
+
+  for (int i = 0; i < DistanceToEdge<dir>(from); i++) {
+    current = Shift<dir>(current);
+    attacks |= current;
+
+    if (occupied & current) break;
+  }
+
+  return attacks;
+}
+
+template <Direction dir>
+constexpr BitBoard SlidingOccupancies(U8 from) {
+  BitBoard attacks;
+  BitBoard current = BitBoard::FromSquare(from);
+
+  for (int i = 1; i < DistanceToEdge<dir>(from); i++) {
+    current = Shift<dir>(current);
+    attacks |= current;
+  }
+
+  return attacks;
+}
+
+// Squares attacked in a direction from each square on an empty board
+template <Direction dir>
+constexpr std::array<BitBoard, kSquareCount> GenerateRays() {
+  std::array<BitBoard, kSquareCount> rays{};
+  for (int square = 0; square < kSquareCount; square++) {
+    rays[square] = SlidingAttacks<dir>(square, 0ULL);
+  }
+  return rays;
+}
+
+template <Direction dir>
+inline constexpr auto kRays = GenerateRays<dir>();
+
+// Attacks in a direction up to and including the first blocker, which cuts
+// off the part of the ray that lies behind it
+template <Direction dir>
+constexpr BitBoard RayAttacks(Square square, const BitBoard &occupied) {
+  constexpr bool kTowardsHigherSquares =
+      dir == Direction::kNorth || dir == Direction::kEast ||
+      dir == Direction::kNorthEast || dir == Direction::kNorthWest;
+
+  const BitBoard ray = kRays<dir>[square];
+  const BitBoard blockers = ray & occupied;
+  if (!blockers) return ray;
+
+  const Square blocker =
+      kTowardsHigherSquares ? blockers.GetLsb() : blockers.GetMsb();
+  return ray ^ kRays<dir>[blocker];
+}
+
+constexpr BitBoard GenerateBishopMask(Square square) {
+  return SlidingOccupancies<Direction::kNorthWest>(square) |
+         SlidingOccupancies<Direction::kNorthEast>(square) |
+         SlidingOccupancies<Direction::kSouthWest>(square) |
+         SlidingOccupancies<Direction::kSouthEast>(square);
+}
+
+constexpr BitBoard GenerateRookMask(Square square) {
+  return SlidingOccupancies<Direction::kNorth>(square) |
+         SlidingOccupancies<Direction::kEast>(square) |
+         SlidingOccupancies<Direction::kSouth>(square) |
+         SlidingOccupancies<Direction::kWest>(square);
+}
+
+constexpr BitBoard GenerateBishopMoves(Square square,
+                                       const BitBoard &occupied) {
+  return RayAttacks<Direction::kNorthWest>(square, occupied) |
+         RayAttacks<Direction::kNorthEast>(square, occupied) |
+         RayAttacks<Direction::kSouthWest>(square, occupied) |
+         RayAttacks<Direction::kSouthEast>(square, occupied);
+}
+
+constexpr BitBoard GenerateRookMoves(Square square,
+                                     const BitBoard &occupied) {
+  return RayAttacks<Direction::kNorth>(square, occupied) |
+         RayAttacks<Direction::kEast>(square, occupied) |
+         RayAttacks<Direction::kSouth>(square, occupied) |
+         RayAttacks<Direction::kWest>(square, occupied);
+}
+
+// Number of attack table entries needed by a set of magics. A square only has
+// as many entries as its mask has subsets of blockers, which the shift of the
+// precomputed magics already reflects
+constexpr std::size_t CountTableEntries(
+    const std::array<MagicEntry, kSquareCount> &magics) {
+  std::size_t entries = 0;
+  for (const auto &entry : magics) entries += 1ULL << (64 - entry.shift);
+  return entries;
+}
 
-using BishopAttacksTable =
-    MultiArray<BitBoard, kSquareCount, kBishopBlockerCombinations>;
-using RookAttacksTable =
-    MultiArray<BitBoard, kSquareCount, kRookBlockerCombinations>;
+constexpr std::size_t kBishopTableEntries = CountTableEntries(kBishopMagics);
+constexpr std::size_t kRookTableEntries = CountTableEntries(kRookMagics);
 
-extern BishopAttacksTable kBishopAttacks;
-extern RookAttacksTable kRookAttacks;
+// The magic of a square along with where its attacks start in the packed
+// table that all squares of both sliders share
+struct SquareAttacks {
+  U64 mask;
+  U64 magic;
+  const BitBoard *attacks;
+  int shift;
+};
 
-U64 GetBishopAttackIndex(Square square, const BitBoard& occupied);
+extern std::array<SquareAttacks, kSquareCount> kBishopAttacks;
+extern std::array<SquareAttacks, kSquareCount> kRookAttacks;
 
-U64 GetRookAttackIndex(Square square, const BitBoard& occupied);
+// Whether the attack tables are indexed with PEXT rather than magics, which is
+// decided at startup from the CPU that the engine runs on
+extern const bool kUsePext;
 
-BitBoard GenerateBishopMask(Square square);
+inline U64 ParallelBitsExtract(U64 value, U64 mask) {
+#if defined(__BMI2__)
+  return _pext_u64(value, mask);
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  // The instruction can be emitted without targeting BMI2, so builds for older
+  // CPUs can still use it when the CPU turns out to support it
+  U64 result;
+  asm("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+  return result;
+#else
+  // Never called since PEXT is only chosen on x86-64
+  return 0;
+#endif
+}
 
-BitBoard GenerateRookMask(Square square);
+inline U64 GetAttackIndex(const SquareAttacks &entry,
+                          const BitBoard &occupied) {
+  if (kUsePext) return ParallelBitsExtract(occupied.AsU64(), entry.mask);
+  return ((occupied.AsU64() & entry.mask) * entry.magic) >> entry.shift;
+}
 
-BitBoard GenerateBishopMoves(Square square, const BitBoard &occupied);
+inline BitBoard GetBishopAttacks(Square square, const BitBoard &occupied) {
+  const auto &entry = kBishopAttacks[square];
+  return entry.attacks[GetAttackIndex(entry, occupied)];
+}
 
-BitBoard GenerateRookMoves(Square square, const BitBoard &occupied);
+inline BitBoard GetRookAttacks(Square square, const BitBoard &occupied) {
+  const auto &entry = kRookAttacks[square];
+  return entry.attacks[GetAttackIndex(entry, occupied)];
+}
 
 std::vector<BitBoard> CreateBlockers(BitBoard moves);
 
 }  // namespace magics::attacks
 
-#endif  // INTEGRAL_MAGICS_ATTACKS_H_
\ No newline at end of file
+#endif  // INTEGRAL_MAGICS_ATTACKS_H_
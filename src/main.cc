@@ -1,6 +1,6 @@
 #include "engine/evaluation/nnue/nnue.h"
-#include "engine/search/cuckoo.h"
 #include "engine/uci/uci.h"
+#include "tests/tests.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -9,6 +9,8 @@ int main(int arg_count, char **args) {
   // Change output buffer size
   setvbuf(stdout, nullptr, _IONBF, 0);
 
+  tests::ReportStartupIfProfiled("main");
+
 #ifdef _WIN32
   // Enable ANSI escape codes
   const auto stdout_handle = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -22,7 +24,5 @@ int main(int arg_count, char **args) {
 
   nnue::LoadFromIncBin();
 
-  search::cuckoo::Initialize();
-
-  uci::AcceptCommands(arg_count, args);
+  return uci::AcceptCommands(arg_count, args);
 }
\ No newline at end of file
@@ -1,84 +1,722 @@
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "../../shared/simd.h"
 #include "../chess/board.h"
 #include "../chess/move_gen.h"
+#include "../magics/attacks.h"
+#include "../engine/evaluation/nnue/kernels/kernels.h"
 #include "../engine/search/search.h"
+#include "../engine/uci/uci.h"
+#include "positions.h"
 #include "tests.h"
 
 namespace tests {
 
-// clang-format off
-constexpr std::array kBenchFens = {
-    "r3k2r/2pb1ppp/2pp1q2/p7/1nP1B3/1P2P3/P2N1PPP/R2QK2R w KQkq a6 0 14",
-    "4rrk1/2p1b1p1/p1p3q1/4p3/2P2n1p/1P1NR2P/PB3PP1/3R1QK1 b - - 2 24",
-    "r3qbrk/6p1/2b2pPp/p3pP1Q/PpPpP2P/3P1B2/2PB3K/R5R1 w - - 16 42",
-    "6k1/1R3p2/6p1/2Bp3p/3P2q1/P7/1P2rQ1K/5R2 b - - 4 44",
-    "8/8/1p2k1p1/3p3p/1p1P1P1P/1P2PK2/8/8 w - - 3 54",
-    "7r/2p3k1/1p1p1qp1/1P1Bp3/p1P2r1P/P7/4R3/Q4RK1 w - - 0 36",
-    "r1bq1rk1/pp2b1pp/n1pp1n2/3P1p2/2P1p3/2N1P2N/PP2BPPP/R1BQ1RK1 b - - 2 10",
-    "3r3k/2r4p/1p1b3q/p4P2/P2Pp3/1B2P3/3BQ1RP/6K1 w - - 3 87",
-    "2r4r/1p4k1/1Pnp4/3Qb1pq/8/4BpPp/5P2/2RR1BK1 w - - 0 42",
-    "4q1bk/6b1/7p/p1p4p/PNPpP2P/KN4P1/3Q4/4R3 b - - 0 37",
-    "2q3r1/1r2pk2/pp3pp1/2pP3p/P1Pb1BbP/1P4Q1/R3NPP1/4R1K1 w - - 2 34",
-    "1r2r2k/1b4q1/pp5p/2pPp1p1/P3Pn2/1P1B1Q1P/2R3P1/4BR1K b - - 1 37",
-    "r3kbbr/pp1n1p1P/3ppnp1/q5N1/1P1pP3/P1N1B3/2P1QP2/R3KB1R b KQkq b3 0 17",
-    "8/6pk/2b1Rp2/3r4/1R1B2PP/P5K1/8/2r5 b - - 16 42",
-    "1r4k1/4ppb1/2n1b1qp/pB4p1/1n1BP1P1/7P/2PNQPK1/3RN3 w - - 8 29",
-    "8/p2B4/PkP5/4p1pK/4Pb1p/5P2/8/8 w - - 29 68",
-    "3r4/ppq1ppkp/4bnp1/2pN4/2P1P3/1P4P1/PQ3PBP/R4K2 b - - 2 20",
-    "5rr1/4n2k/4q2P/P1P2n2/3B1p2/4pP2/2N1P3/1RR1K2Q w - - 1 49",
-    "1r5k/2pq2p1/3p3p/p1pP4/4QP2/PP1R3P/6PK/8 w - - 1 51",
-    "q5k1/5ppp/1r3bn1/1B6/P1N2P2/BQ2P1P1/5K1P/8 b - - 2 34",
-    "r1b2k1r/5n2/p4q2/1ppn1Pp1/3pp1p1/NP2P3/P1PPBK2/1RQN2R1 w - - 0 22",
-    "r1bqk2r/pppp1ppp/5n2/4b3/4P3/P1N5/1PP2PPP/R1BQKB1R w KQkq - 0 5",
-    "r1bqr1k1/pp1p1ppp/2p5/8/3N1Q2/P2BB3/1PP2PPP/R3K2n b Q - 1 12",
-    "r1bq2k1/p4r1p/1pp2pp1/3p4/1P1B3Q/P2B1N2/2P3PP/4R1K1 b - - 2 19",
-    "r4qk1/6r1/1p4p1/2ppBbN1/1p5Q/P7/2P3PP/5RK1 w - - 2 25",
-    "r7/6k1/1p6/2pp1p2/7Q/8/p1P2K1P/8 w - - 0 32",
-    "r3k2r/ppp1pp1p/2nqb1pn/3p4/4P3/2PP4/PP1NBPPP/R2QK1NR w KQkq - 1 5",
-    "3r1rk1/1pp1pn1p/p1n1q1p1/3p4/Q3P3/2P5/PP1NBPPP/4RRK1 w - - 0 12",
-    "5rk1/1pp1pn1p/p3Brp1/8/1n6/5N2/PP3PPP/2R2RK1 w - - 2 20",
-    "8/1p2pk1p/p1p1r1p1/3n4/8/5R2/PP3PPP/4R1K1 b - - 3 27",
-    "8/4pk2/1p1r2p1/p1p4p/Pn5P/3R4/1P3PP1/4RK2 w - - 1 33",
-    "8/5k2/1pnrp1p1/p1p4p/P6P/4R1PK/1P3P2/4R3 b - - 1 38",
-    "8/8/1p1kp1p1/p1pr1n1p/P6P/1R4P1/1P3PK1/1R6 b - - 15 45",
-    "8/8/1p1k2p1/p1prp2p/P2n3P/6P1/1P1R1PK1/4R3 b - - 5 49",
-    "8/8/1p4p1/p1p2k1p/P2npP1P/4K1P1/1P6/3R4 w - - 6 54",
-    "8/8/1p4p1/p1p2k1p/P2n1P1P/4K1P1/1P6/6R1 b - - 6 59",
-    "8/5k2/1p4p1/p1pK3p/P2n1P1P/6P1/1P6/4R3 b - - 14 63",
-    "8/1R6/1p1K1kp1/p6p/P1p2P1P/6P1/1Pn5/8 w - - 0 67",
-    "1rb1rn1k/p3q1bp/2p3p1/2p1p3/2P1P2N/PP1RQNP1/1B3P2/4R1K1 b - - 4 23",
-    "4rrk1/pp1n1pp1/q5p1/P1pP4/2n3P1/7P/1P3PB1/R1BQ1RK1 w - - 3 22",
-    "r2qr1k1/pb1nbppp/1pn1p3/2ppP3/3P4/2PB1NN1/PP3PPP/R1BQR1K1 w - - 4 12",
-    "2r2k2/8/4P1R1/1p6/8/P4K1N/7b/2B5 b - - 0 55",
-    "6k1/5pp1/8/2bKP2P/2P5/p4PNb/B7/8 b - - 1 44",
-    "2rqr1k1/1p3p1p/p2p2p1/P1nPb3/2B1P3/5P2/1PQ2NPP/R1R4K w - - 3 25",
-    "r1b2rk1/p1q1ppbp/6p1/2Q5/8/4BP2/PPP3PP/2KR1B1R b - - 2 14",
-    "6r1/5k2/p1b1r2p/1pB1p1p1/1Pp3PP/2P1R1K1/2P2P2/3R4 w - - 1 36",
-    "rnbqkb1r/pppppppp/5n2/8/2PP4/8/PP2PPPP/RNBQKBNR b KQkq c3 0 2",
-    "2rr2k1/1p4bp/p1q1p1p1/4Pp1n/2PB4/1PN3P1/P3Q2P/2RR2K1 w - f6 0 20",
-    "3br1k1/p1pn3p/1p3n2/5pNq/2P1p3/1PN3PP/P2Q1PB1/4R1K1 w - - 0 23",
-    "2r2b2/5p2/5k2/p1r1pP2/P2pB3/1P3P2/K1P3R1/7R w - - 23 93"
+struct BenchPosition {
+  std::string fen;
+  U64 nodes;
+  U64 microseconds;
+  int depth;
+  int sel_depth;
+  std::string best_move;
 };
-// clang-format on
 
-void BenchSuite(int depth) {
+// Searches every bench position to a fixed depth on a single thread, which
+// gives a node count that only changes when the search behaves differently
+std::vector<BenchPosition> RunBench(int depth) {
   Board board;
   search::Searcher searcher(board);
   searcher.ResizeHash(16);
 
   auto bench_thread = std::make_unique<search::Thread>(0);
 
-  U64 nodes = 0, elapsed = 0;
+  std::vector<BenchPosition> positions;
+  search::SearchStats stats;
   for (const auto &position : kBenchFens) {
     board.SetFromFen(position);
     searcher.NewGame(false);
 
-    nodes += searcher.Bench(bench_thread, depth);
-    elapsed += searcher.GetTimeManagement().TimeElapsed();
+    const auto start = std::chrono::steady_clock::now();
+    const U64 nodes = searcher.Bench(bench_thread, depth);
+    const auto end = std::chrono::steady_clock::now();
+
+    positions.push_back({
+        position,
+        nodes,
+        static_cast<U64>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+                .count()),
+        bench_thread->root_depth,
+        bench_thread->sel_depth,
+        bench_thread->root_moves.Empty()
+            ? "0000"
+            : bench_thread->root_moves[0].move.ToString(),
+    });
+    stats += bench_thread->stats;
   }
 
+  search::SetLastSearchStats(stats);
+  return positions;
+}
+
+[[nodiscard]] U64 TotalNodes(const std::vector<BenchPosition> &positions) {
+  return std::accumulate(
+      positions.begin(), positions.end(), 0ULL, [](U64 sum, const auto &pos) {
+        return sum + pos.nodes;
+      });
+}
+
+[[nodiscard]] double Nps(const std::vector<BenchPosition> &positions) {
+  const U64 microseconds = std::accumulate(
+      positions.begin(), positions.end(), 0ULL, [](U64 sum, const auto &pos) {
+        return sum + pos.microseconds;
+      });
+  return TotalNodes(positions) * 1000000.0 / std::max<U64>(microseconds, 1);
+}
+
+void BenchSuite(int depth) {
+  const auto positions = RunBench(depth);
   fmt::println("{} nodes {} nps",
-               nodes,
-               static_cast<U64>(nodes * 1000 / std::max<U64>(elapsed, 1)));
+               TotalNodes(positions),
+               static_cast<U64>(Nps(positions)));
+}
+
+namespace {
+
+// The build flags that affect speed, which should match between runs that are
+// compared
+[[nodiscard]] std::string BuildFlagsJson() {
+  std::vector<std::string> flags;
+  const auto add_flag = [&flags](std::string_view name, bool enabled) {
+    flags.push_back(fmt::format("\"{}\": {}", name, enabled));
+  };
+
+#if BUILD_HAS_AVX512VNNI
+  add_flag("avx512vnni", true);
+#else
+  add_flag("avx512vnni", false);
+#endif
+#if BUILD_HAS_AVX512
+  add_flag("avx512", true);
+#else
+  add_flag("avx512", false);
+#endif
+#if BUILD_HAS_AVX2
+  add_flag("avx2", true);
+#else
+  add_flag("avx2", false);
+#endif
+#if BUILD_HAS_BMI2
+  add_flag("bmi2", true);
+#else
+  add_flag("bmi2", false);
+#endif
+  add_flag("pext", magics::attacks::kUsePext);
+  flags.push_back(
+      fmt::format("\"kernels\": \"{}\"", nnue::kernels::kKernels.name));
+#if BUILD_HAS_NEON
+  add_flag("neon", true);
+#else
+  add_flag("neon", false);
+#endif
+
+  return fmt::format("{{{}}}", fmt::join(flags, ", "));
+}
+
+// Finds the value of the first "key": after the given offset. This only
+// understands the JSON written by BenchJsonSuite(), where every position sits
+// on its own line and strings never contain quotes
+[[nodiscard]] std::optional<std::string_view> FindJsonValue(
+    std::string_view text, std::string_view key, std::size_t offset = 0) {
+  const auto quoted_key = fmt::format("\"{}\":", key);
+  auto start = text.find(quoted_key, offset);
+  if (start == std::string_view::npos) return std::nullopt;
+
+  start = text.find_first_not_of(' ', start + quoted_key.size());
+  if (start == std::string_view::npos) return std::nullopt;
+
+  std::size_t end;
+  if (text[start] == '"') {
+    end = text.find('"', ++start);
+  } else if (text[start] == '[' || text[start] == '{') {
+    end = text.find(text[start] == '[' ? ']' : '}', start) + 1;
+  } else {
+    end = text.find_first_of(",}\n", start);
+  }
+
+  if (end == std::string_view::npos || end < start) return std::nullopt;
+  return text.substr(start, end - start);
+}
+
+struct BenchBaseline {
+  int depth = 0;
+  std::string build;
+  std::vector<double> nps;
+  std::vector<BenchPosition> positions;
+};
+
+[[nodiscard]] std::optional<BenchBaseline> LoadBenchBaseline(
+    const std::string &path) {
+  std::ifstream file(path);
+  if (!file) return std::nullopt;
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string text = buffer.str();
+
+  const auto depth = FindJsonValue(text, "depth");
+  const auto build = FindJsonValue(text, "build");
+  const auto nps = FindJsonValue(text, "nps");
+  if (!depth || !build || !nps) return std::nullopt;
+
+  BenchBaseline baseline;
+  try {
+    baseline.depth = std::stoi(std::string(*depth));
+    baseline.build = *build;
+    for (const auto &run :
+         SplitString(nps->substr(1, nps->size() - 2), ',')) {
+      baseline.nps.push_back(std::stod(run));
+    }
+
+    for (auto pos = text.find("{\"fen\":"); pos != std::string::npos;
+         pos = text.find("{\"fen\":", pos + 1)) {
+      const auto fen = FindJsonValue(text, "fen", pos);
+      const auto nodes = FindJsonValue(text, "nodes", pos);
+      const auto best_move = FindJsonValue(text, "bestmove", pos);
+      if (!fen || !nodes || !best_move) return std::nullopt;
+
+      baseline.positions.push_back({std::string(*fen),
+                                    std::stoull(std::string(*nodes)),
+                                    0,
+                                    0,
+                                    0,
+                                    std::string(*best_move)});
+    }
+  } catch (...) {
+    return std::nullopt;
+  }
+
+  if (baseline.nps.empty()) return std::nullopt;
+  return baseline;
+}
+
+struct Sample {
+  double mean, variance;
+  std::size_t size;
+};
+
+[[nodiscard]] Sample Summarize(const std::vector<double> &values) {
+  const double mean =
+      std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+  double variance = 0;
+  for (const double value : values) {
+    variance += (value - mean) * (value - mean);
+  }
+  return {mean, values.size() > 1 ? variance / (values.size() - 1) : 0.0,
+          values.size()};
+}
+
+// One-sided 95% critical values of Student's t-distribution, rounding the
+// degrees of freedom down to be conservative
+[[nodiscard]] double CriticalT(double degrees_of_freedom) {
+  constexpr std::array<std::pair<double, double>, 14> kTable = {{
+      {1, 6.314},
+      {2, 2.920},
+      {3, 2.353},
+      {4, 2.132},
+      {5, 2.015},
+      {6, 1.943},
+      {7, 1.895},
+      {8, 1.860},
+      {9, 1.833},
+      {10, 1.812},
+      {15, 1.753},
+      {20, 1.725},
+      {30, 1.697},
+      {120, 1.658},
+  }};
+
+  double critical = kTable.front().second;
+  for (const auto &[df, t] : kTable) {
+    if (degrees_of_freedom >= df) critical = t;
+  }
+  return critical;
+}
+
+// Runs the bench several times, keeping the positions of the first run with
+// the median time of each position across runs. Returns the NPS of every run
+std::vector<double> RunBenchRepeatedly(
+    int depth, int runs, std::vector<BenchPosition> &positions) {
+  std::vector<double> nps;
+  std::vector<std::vector<U64>> times(kBenchFens.size());
+  for (int run = 0; run < runs; run++) {
+    const auto result = RunBench(depth);
+    nps.push_back(Nps(result));
+    for (std::size_t i = 0; i < result.size(); i++) {
+      times[i].push_back(result[i].microseconds);
+    }
+    if (run == 0) positions = result;
+  }
+
+  // Report the median time of each position, which is less affected by noise
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    std::sort(times[i].begin(), times[i].end());
+    positions[i].microseconds = times[i][times[i].size() / 2];
+  }
+
+  return nps;
+}
+
+}  // namespace
+
+void BenchJsonSuite(int depth, int runs, const std::string &out_path) {
+  std::vector<BenchPosition> positions;
+  const auto nps = RunBenchRepeatedly(depth, runs, positions);
+
+  std::string json = "{\n";
+  json += fmt::format("  \"engine\": \"{}\",\n",
+                      uci::constants::kEngineName);
+  json += fmt::format("  \"depth\": {},\n", depth);
+  json += fmt::format("  \"build\": {},\n", BuildFlagsJson());
+  json += fmt::format("  \"nodes\": {},\n", TotalNodes(positions));
+  json += fmt::format("  \"nps\": [{:.0f}],\n", fmt::join(nps, ", "));
+  json += "  \"positions\": [\n";
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    const auto &pos = positions[i];
+    json += fmt::format(
+        R"(    {{"fen": "{}", "nodes": {}, "time_us": {}, "nps": {}, )"
+        R"("depth": {}, "seldepth": {}, "bestmove": "{}"}}{})"
+        "\n",
+        pos.fen,
+        pos.nodes,
+        pos.microseconds,
+        pos.nodes * 1000000 / std::max<U64>(pos.microseconds, 1),
+        pos.depth,
+        pos.sel_depth,
+        pos.best_move,
+        i + 1 < positions.size() ? "," : "");
+  }
+  json += "  ]\n}\n";
+
+  if (out_path.empty()) {
+    fmt::print("{}", json);
+    return;
+  }
+
+  std::ofstream file(out_path);
+  if (!file || !(file << json)) {
+    fmt::println("info string Failed to write bench results to {}", out_path);
+  }
+}
+
+bool BenchCompareSuite(const std::string &baseline_path, int runs) {
+  const auto baseline = LoadBenchBaseline(baseline_path);
+  if (!baseline) {
+    fmt::println("bench compare: could not read a baseline from {}",
+                 baseline_path);
+    return false;
+  }
+
+  if (baseline->build != BuildFlagsJson()) {
+    fmt::println("warning: build flags differ from the baseline {}",
+                 baseline->build);
+  }
+
+  std::vector<BenchPosition> positions;
+  const auto nps = RunBenchRepeatedly(baseline->depth, runs, positions);
+
+  // Any change in node counts means the search behaves differently, which is
+  // never expected from a change that should only affect speed
+  bool signature_matches = positions.size() == baseline->positions.size();
+  for (std::size_t i = 0; signature_matches && i < positions.size(); i++) {
+    const auto &current = positions[i], &expected = baseline->positions[i];
+    if (current.fen != expected.fen) {
+      signature_matches = false;
+      break;
+    }
+
+    if (current.nodes != expected.nodes) {
+      signature_matches = false;
+      fmt::println("signature: {} nodes {} -> {}, bestmove {} -> {}",
+                   current.fen,
+                   expected.nodes,
+                   current.nodes,
+                   expected.best_move,
+                   current.best_move);
+    }
+  }
+
+  fmt::println("signature: {} nodes, baseline {} nodes, {}",
+               TotalNodes(positions),
+               TotalNodes(baseline->positions),
+               signature_matches ? "match" : "CHANGED");
+
+  // Welch's t-test, which doesn't assume both sets of runs are equally noisy
+  const auto current = Summarize(nps), expected = Summarize(baseline->nps);
+  const double current_error = current.variance / current.size;
+  const double expected_error = expected.variance / expected.size;
+  const double standard_error = std::sqrt(current_error + expected_error);
+
+  bool regression = false;
+  if (standard_error > 0) {
+    const double t = (current.mean - expected.mean) / standard_error;
+    double degrees_of_freedom = 1;
+    if (current.size > 1 && expected.size > 1) {
+      degrees_of_freedom =
+          std::pow(current_error + expected_error, 2) /
+          (current_error * current_error / (current.size - 1) +
+           expected_error * expected_error / (expected.size - 1));
+    }
+    regression = t < -CriticalT(degrees_of_freedom);
+    fmt::println(
+        "nps: {:.0f} ± {:.0f} ({} runs), baseline {:.0f} ± {:.0f} ({} runs), "
+        "{:+.2f}%, t = {:.2f}",
+        current.mean,
+        std::sqrt(current.variance),
+        current.size,
+        expected.mean,
+        std::sqrt(expected.variance),
+        expected.size,
+        100.0 * (current.mean / expected.mean - 1),
+        t);
+  } else {
+    fmt::println("nps: not enough variance across runs to test significance");
+  }
+
+  if (regression) {
+    fmt::println("nps: significant REGRESSION");
+  }
+
+  const bool passed = signature_matches && !regression;
+  fmt::println("bench compare: {}", passed ? "pass" : "FAIL");
+  return passed;
+}
+
+struct SmpBenchResult {
+  U64 nodes;
+  U64 microseconds;
+  U64 tt_collisions;
+};
+
+// Searches every bench position with the given limits through the regular
+// multi-threaded search, measuring the time it takes to finish
+SmpBenchResult RunSmpBench(const search::TimeConfig &config,
+                           int threads,
+                           int hash,
+                           bool abdada) {
+  Board board;
+  search::Searcher searcher(board);
+  searcher.ResizeHash(hash);
+  searcher.SetThreadCount(threads);
+  searcher.SetAbdada(abdada);
+  searcher.SetSilent(true);
+
+  SmpBenchResult result{0, 0, 0};
+  for (const auto &position : kBenchFens) {
+    board.SetFromFen(position);
+    searcher.NewGame();
+
+    const auto start = std::chrono::steady_clock::now();
+    searcher.Start(config);
+    searcher.Wait();
+    const auto end = std::chrono::steady_clock::now();
+
+    result.nodes += searcher.GetNodesSearched();
+    result.tt_collisions += searcher.GetStats().tt_collisions;
+    result.microseconds +=
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count();
+  }
+
+  return result;
+}
+
+void SmpBenchSuite(int depth, int threads, int hash) {
+  const auto print_result = [&](std::string_view name,
+                                const SmpBenchResult &result) {
+    fmt::println(
+        "{:>9}: {} threads, time to depth {} {} ms, {} nodes {} nps, {} tt "
+        "collisions",
+        name,
+        threads,
+        depth,
+        result.microseconds / 1000,
+        result.nodes,
+        result.nodes * 1000000 / std::max<U64>(result.microseconds, 1),
+        result.tt_collisions);
+  };
+
+  const search::TimeConfig config{.depth = depth};
+  const auto lazy_smp = RunSmpBench(config, threads, hash, false);
+  print_result("lazy smp", lazy_smp);
+
+  const auto abdada = RunSmpBench(config, threads, hash, true);
+  print_result("abdada", abdada);
+
+  const auto nps = [](const SmpBenchResult &result) {
+    return static_cast<double>(result.nodes) /
+           std::max<U64>(result.microseconds, 1);
+  };
+  fmt::println("abdada vs lazy smp: time to depth {:.3f}x, nps {:.3f}x",
+               static_cast<double>(lazy_smp.microseconds) /
+                   std::max<U64>(abdada.microseconds, 1),
+               nps(abdada) / nps(lazy_smp));
+}
+
+void ScalingBenchSuite(const ScalingBenchOptions &options) {
+  struct Summary {
+    double median, stddev;
+  };
+
+  const auto summarize = [](std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    const auto size = samples.size();
+    const double median =
+        size % 2 ? samples[size / 2]
+                 : (samples[size / 2 - 1] + samples[size / 2]) / 2;
+
+    const double mean = std::accumulate(samples.begin(), samples.end(), 0.0) /
+                        static_cast<double>(size);
+    double variance = 0;
+    for (const double sample : samples) {
+      variance += (sample - mean) * (sample - mean);
+    }
+    return Summary{median, std::sqrt(variance / static_cast<double>(size))};
+  };
+
+  std::vector<int> thread_counts;
+  for (int threads = 1; threads < options.max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(std::max(options.max_threads, 1));
+
+  const bool fixed_depth = options.move_time == 0;
+  const search::TimeConfig config{.depth = fixed_depth ? options.depth : 0,
+                                  .move_time = options.move_time};
+
+  if (fixed_depth) {
+    fmt::println("{} positions to depth {}, {} MB hash, {} repetitions",
+                 kBenchFens.size(),
+                 options.depth,
+                 options.hash,
+                 options.repetitions);
+  } else {
+    fmt::println("{} positions for {} ms each, {} MB hash, {} repetitions",
+                 kBenchFens.size(),
+                 options.move_time,
+                 options.hash,
+                 options.repetitions);
+  }
+
+  fmt::println("{:>7} {:>21} {:>23} {:>8} {:>10}",
+               "threads",
+               fixed_depth ? "time to depth (ms)" : "time (ms)",
+               "nps",
+               "speedup",
+               "efficiency");
+
+  Summary base_time{}, base_nps{};
+  for (const int threads : thread_counts) {
+    std::vector<double> times, nps;
+    for (int i = 0; i < options.repetitions; i++) {
+      const auto result = RunSmpBench(config, threads, options.hash, false);
+      times.push_back(result.microseconds / 1000.0);
+      nps.push_back(result.nodes * 1000000.0 /
+                    std::max<U64>(result.microseconds, 1));
+    }
+
+    const auto time = summarize(times), speed = summarize(nps);
+    if (threads == thread_counts.front()) {
+      base_time = time, base_nps = speed;
+    }
+
+    // With a fixed depth the speedup is how much sooner the depth is reached,
+    // otherwise all we can measure is how many more nodes are searched
+    const double speedup = fixed_depth ? base_time.median / time.median
+                                       : speed.median / base_nps.median;
+    fmt::println(
+        "{:>7} {:>12.0f} ± {:<6.0f} {:>12.0f} ± {:<8.0f} {:>7.2f}x {:>9.1f}%",
+        threads,
+        time.median,
+        time.stddev,
+        speed.median,
+        speed.stddev,
+        speedup,
+        100.0 * speedup * thread_counts.front() / threads);
+  }
+}
+
+void LatencyBenchSuite(int max_threads) {
+  constexpr int kRepetitions = 50;
+
+  std::vector<int> thread_counts;
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(std::max(max_threads, 1));
+
+  const auto percentile = [](std::vector<U64> &samples, double fraction) {
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(fraction * (samples.size() - 1))];
+  };
+
+  for (const int threads : thread_counts) {
+    Board board;
+    search::Searcher searcher(board);
+    searcher.ResizeHash(16);
+    searcher.SetThreadCount(threads);
+    searcher.SetSilent(true);
+    board.SetFromFen(kBenchFens[0]);
+
+    std::vector<U64> start_latencies, stop_latencies, setup_times;
+    for (int i = 0; i < kRepetitions; i++) {
+      searcher.NewGame(false);
+
+      // Time until the first node is searched after go
+      const auto go_time = std::chrono::steady_clock::now();
+      searcher.Start(search::TimeConfig{.infinite = true});
+      while (searcher.GetNodesSearched() == 0) std::this_thread::yield();
+      const auto first_node_time = std::chrono::steady_clock::now();
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+      // Time until every thread stopped and the best move would be reported
+      const auto stop_time = std::chrono::steady_clock::now();
+      searcher.Stop();
+      const auto stopped_time = std::chrono::steady_clock::now();
+
+      start_latencies.push_back(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              first_node_time - go_time)
+              .count());
+      stop_latencies.push_back(
+          std::chrono::duration_cast<std::chrono::microseconds>(stopped_time -
+                                                                stop_time)
+              .count());
+
+      // Time each thread took to copy the position before it started
+      for (const auto &thread_stats : searcher.GetThreadStats()) {
+        setup_times.push_back(thread_stats.board_setup_nanoseconds);
+      }
+    }
+
+    fmt::println(
+        "{:>3} threads: go -> first node {} us (p90 {} us), stop -> bestmove "
+        "{} us (p90 {} us), board setup per thread {:.1f} us (p90 {:.1f} us)",
+        threads,
+        percentile(start_latencies, 0.5),
+        percentile(start_latencies, 0.9),
+        percentile(stop_latencies, 0.5),
+        percentile(stop_latencies, 0.9),
+        percentile(setup_times, 0.5) / 1000.0,
+        percentile(setup_times, 0.9) / 1000.0);
+  }
+}
+
+void PerfBenchSuite(int depth, int threads, int hash) {
+  Board board;
+  search::Searcher searcher(board);
+  searcher.ResizeHash(hash);
+  searcher.SetThreadCount(threads);
+  searcher.SetSilent(true);
+
+  if (const auto error = searcher.OpenPerfCounters()) {
+    fmt::println("perf counters unavailable: {}", *error);
+    return;
+  }
+
+  // Rates per node, which are comparable between positions and threads that
+  // searched a different number of nodes
+  const auto print_counts = [](std::string_view label,
+                               U64 nodes,
+                               const perf::Counts &counts) {
+    std::string line = fmt::format("{:<12} {:>10}", label, nodes);
+    if (counts.available[perf::kCycles] &&
+        counts.available[perf::kInstructions]) {
+      line += fmt::format(" {:>6.2f}", counts.InstructionsPerCycle());
+    } else {
+      line += fmt::format(" {:>6}", "n/a");
+    }
+
+    for (int event = 0; event < perf::kNumEvents; event++) {
+      if (counts.available[event]) {
+        const auto per_node = static_cast<double>(counts.values[event]) /
+                              std::max<U64>(nodes, 1);
+        line += fmt::format(" {:>13.2f}", per_node);
+      } else {
+        line += fmt::format(" {:>13}", "n/a");
+      }
+    }
+    fmt::println("{}", line);
+  };
+
+  const auto print_header = [](std::string_view label) {
+    std::string line =
+        fmt::format("{:<12} {:>10} {:>6}", label, "nodes", "IPC");
+    for (const auto name : perf::kEventNames) {
+      line += fmt::format(" {:>13}", name);
+    }
+    fmt::println("{}", line);
+  };
+
+  fmt::println(
+      "counting user space events per node at depth {} with {} threads, {} MB "
+      "hash on {}",
+      depth,
+      threads,
+      hash,
+      memory::PageTypeName(searcher.GetHashPageType()));
+  print_header("position");
+
+  std::vector<U64> thread_nodes(threads);
+  std::vector<perf::Counts> thread_counts(threads);
+  U64 total_nodes = 0;
+  perf::Counts total_counts;
+
+  for (std::size_t i = 0; i < kBenchFens.size(); i++) {
+    board.SetFromFen(kBenchFens[i]);
+    searcher.NewGame();
+
+    searcher.Start({.depth = depth});
+    searcher.Wait();
+
+    const auto stats = searcher.GetThreadStats();
+    const auto counts = searcher.TakePerfCounts();
+
+    U64 position_nodes = 0;
+    perf::Counts position_counts;
+    for (int thread = 0; thread < threads; thread++) {
+      thread_nodes[thread] += stats[thread].nodes;
+      thread_counts[thread] += counts[thread];
+      position_nodes += stats[thread].nodes;
+      position_counts += counts[thread];
+    }
+    print_counts(fmt::format("{}", i + 1), position_nodes, position_counts);
+
+    total_nodes += position_nodes;
+    total_counts += position_counts;
+  }
+
+  if (threads > 1) {
+    fmt::println("");
+    print_header("thread");
+    for (int thread = 0; thread < threads; thread++) {
+      print_counts(fmt::format("{}", thread),
+                   thread_nodes[thread],
+                   thread_counts[thread]);
+    }
+  }
+
+  fmt::println("");
+  print_counts("total", total_nodes, total_counts);
 }
 
-}  // namespace tests
\ No newline at end of file
+}  // namespace tests
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include "tests.h"
+
+#if defined(__linux__)
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace tests {
+
+namespace {
+
+// Set in the environment of the engines started by the profile, which then
+// report when they enter main() and when they finished initializing
+constexpr const char *kStartupProfileEnv = "INTEGRAL_STARTUP_PROFILE";
+
+[[nodiscard]] long long SteadyNanoseconds() {
+  return duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+#if defined(__linux__)
+
+// Time in nanoseconds from spawning the engine until it entered main(), until
+// it finished initializing and until it answered uci with uciok
+struct StartupTimes {
+  long long main, initialized, uciok;
+};
+
+std::optional<StartupTimes> ProfileStartup() {
+  std::array<int, 2> to_engine{}, from_engine{};
+  if (pipe(to_engine.data()) != 0) return std::nullopt;
+  if (pipe(from_engine.data()) != 0) {
+    close(to_engine[0]);
+    close(to_engine[1]);
+    return std::nullopt;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, to_engine[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, from_engine[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, to_engine[1]);
+  posix_spawn_file_actions_addclose(&actions, from_engine[0]);
+
+  char name[] = "integral";
+  char *const argv[] = {name, nullptr};
+
+  pid_t pid;
+  const long long start = SteadyNanoseconds();
+  const int error =
+      posix_spawn(&pid, "/proc/self/exe", &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+
+  close(to_engine[0]);
+  close(from_engine[1]);
+  if (error != 0) {
+    close(to_engine[1]);
+    close(from_engine[0]);
+    return std::nullopt;
+  }
+
+  // The command waits in the pipe until the engine starts reading input
+  constexpr std::string_view kUci = "uci\n";
+  [[maybe_unused]] auto written = write(to_engine[1], kUci.data(), kUci.size());
+
+  StartupTimes times{-1, -1, -1};
+  FILE *output = fdopen(from_engine[0], "r");
+  std::array<char, 4096> line{};
+  while (output && fgets(line.data(), line.size(), output)) {
+    const long long now = SteadyNanoseconds();
+
+    // The steady clock is shared between processes, so the engine reports the
+    // times that it reached each phase in the same clock
+    long long phase_time;
+    if (std::sscanf(
+            line.data(), "info string startup main %lld", &phase_time) == 1) {
+      times.main = phase_time - start;
+    } else if (std::sscanf(line.data(),
+                           "info string startup initialized %lld",
+                           &phase_time) == 1) {
+      times.initialized = phase_time - start;
+    }
+
+    if (std::strncmp(line.data(), "uciok", 5) == 0) {
+      times.uciok = now - start;
+      break;
+    }
+  }
+
+  constexpr std::string_view kQuit = "quit\n";
+  written = write(to_engine[1], kQuit.data(), kQuit.size());
+  close(to_engine[1]);
+
+  // Drain the output so that the engine never blocks on a full pipe
+  while (output && fgets(line.data(), line.size(), output)) {
+  }
+  if (output) {
+    fclose(output);
+  } else {
+    close(from_engine[0]);
+  }
+
+  int status;
+  waitpid(pid, &status, 0);
+
+  if (times.main < 0 || times.initialized < 0 || times.uciok < 0) {
+    return std::nullopt;
+  }
+  return times;
+}
+
+#endif
+
+}  // namespace
+
+void ReportStartupIfProfiled(std::string_view phase) {
+  if (std::getenv(kStartupProfileEnv)) {
+    fmt::println("info string startup {} {}", phase, SteadyNanoseconds());
+  }
+}
+
+void StartupProfile(int runs) {
+#if defined(__linux__)
+  setenv(kStartupProfileEnv, "1", 1);
+
+  std::vector<long long> to_main, to_initialized, to_uciok;
+  for (int run = 0; run < runs; run++) {
+    const auto times = ProfileStartup();
+    if (!times) {
+      fmt::println("failed to start the engine");
+      unsetenv(kStartupProfileEnv);
+      return;
+    }
+
+    to_main.push_back(times->main);
+    to_initialized.push_back(times->initialized - times->main);
+    to_uciok.push_back(times->uciok - times->initialized);
+  }
+
+  unsetenv(kStartupProfileEnv);
+
+  const auto print_phase = [](std::string_view phase,
+                              std::vector<long long> &times) {
+    std::ranges::sort(times);
+    fmt::println("{:<22} {:>9.3f} {:>9.3f} {:>9.3f}",
+                 phase,
+                 times.front() / 1e6,
+                 times[times.size() / 2] / 1e6,
+                 times.back() / 1e6);
+  };
+
+  std::vector<long long> total(runs);
+  for (int run = 0; run < runs; run++) {
+    total[run] = to_main[run] + to_initialized[run] + to_uciok[run];
+  }
+
+  fmt::println("startup over {} runs in ms", runs);
+  fmt::println("{:<22} {:>9} {:>9} {:>9}", "phase", "min", "median", "max");
+  // Loading the executable and running the static initializers
+  print_phase("exec to main", to_main);
+  // Creating the searcher, its threads and the options
+  print_phase("main to initialized", to_initialized);
+  print_phase("initialized to uciok", to_uciok);
+  print_phase("exec to uciok", total);
+#else
+  fmt::println("startup profile is not supported on this platform");
+#endif
+}
+
+}  // namespace tests
@@ -6,6 +6,8 @@
 #include <chrono>
 #include <ranges>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "../utils/string.h"
@@ -19,11 +21,67 @@ constexpr int kDefaultBenchDepth = 12;
 
 void BenchSuite(int depth);
 
+// Writes the results of the bench as JSON, including the NPS of several runs
+// and the build flags, to the file or to stdout if no path is given
+void BenchJsonSuite(int depth, int runs, const std::string &out_path);
+
+// Runs the bench against a baseline written by BenchJsonSuite(), reporting
+// node count changes and NPS regressions that are statistically significant.
+// Returns whether the comparison passed
+bool BenchCompareSuite(const std::string &baseline_path, int runs);
+
+// Compares plain Lazy SMP against ABDADA-style move deferral
+void SmpBenchSuite(int depth, int threads, int hash);
+
+struct ScalingBenchOptions {
+  int depth = kDefaultBenchDepth;
+  // Searches each position for this many milliseconds instead of to a fixed
+  // depth if set
+  int move_time = 0;
+  int max_threads = 1;
+  int hash = 64;
+  int repetitions = 3;
+};
+
+// Runs the bench positions through the regular search for 1, 2, 4 ... up to
+// the maximum number of threads, reporting the median and standard deviation
+// of the time and speed along with the speedup over a single thread
+void ScalingBenchSuite(const ScalingBenchOptions &options);
+
+// Measures the round trips of starting and stopping a search for increasing
+// thread counts up to the given number
+void LatencyBenchSuite(int max_threads);
+
+// Reads the hardware performance counters of every search thread while
+// searching the bench positions, reporting them per position and per thread
+void PerfBenchSuite(int depth, int threads, int hash);
+
 void SEESuite();
 
-void PerftSuite();
+// Size in megabytes of the perft table unless another size is given, which is
+// kept apart from the Hash option so that perft doesn't allocate a second
+// table as large as the search's
+constexpr int kDefaultPerftHash = 16;
+
+// Runs the perft suite on the given number of threads, sharing a perft table
+// of the given size in megabytes between them (disabled if 0)
+void PerftSuite(int threads, int hash);
+
+// Counts the leaf nodes at the given depth, splitting the root moves across
+// threads that share a perft table of the given size in megabytes (disabled if
+// 0). Reports the node count below each root move and the raw speed of the
+// move generation
+void Perft(Board &board, int depth, int threads, int hash);
+
+// Starts the engine the given number of times and measures how long it takes
+// from the start of the process until it answers uci, split into the loading
+// of the executable, the initialization of the engine and the uci response
+void StartupProfile(int runs);
 
-void Perft(Board &board, int depth);
+// Reports the time that the given phase of startup was reached (main() was
+// entered or the engine finished initializing) when the engine was started by
+// StartupProfile()
+void ReportStartupIfProfiled(std::string_view phase);
 
 }  // namespace tests
 
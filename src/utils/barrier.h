@@ -3,11 +3,41 @@
 
 #include <atomic>
 #include <cassert>
-#include <condition_variable>
-#include <mutex>
 
 #include "types.h"
 
+// Hints to the CPU that the thread is busy waiting, which frees up resources
+// for the sibling hyperthread and avoids a memory order flush when the wait
+// ends
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Number of times a waiting thread polls before going to sleep. Waking a
+// sleeping thread costs tens of microseconds, while the other participants of
+// a search handshake usually arrive within a few microseconds
+constexpr int kSpinIterations = 1024;
+
+// Waits until the atomic no longer holds the given value by spinning for a
+// short while before sleeping in the kernel (a futex on Linux), which bounds
+// the wake-up latency without burning a core on long waits. The writer must
+// call notify_all() after changing the value
+template <typename T>
+void SpinWait(const std::atomic<T> &atomic, T old_value) {
+  for (int i = 0; i < kSpinIterations; i++) {
+    if (atomic.load(std::memory_order::acquire) != old_value) return;
+    CpuRelax();
+  }
+
+  while (atomic.load(std::memory_order::acquire) == old_value) {
+    atomic.wait(old_value, std::memory_order::acquire);
+  }
+}
+
 class Barrier {
  public:
   explicit Barrier(I64 expected) {
@@ -23,22 +53,18 @@ class Barrier {
   }
 
   void ArriveAndWait() {
-    std::unique_lock lock{wait_mutex_};
+    // The phase can't advance before this thread arrives, so it must be read
+    // beforehand
+    const auto phase = phase_.load(std::memory_order::acquire);
 
-    const auto current = --current_;
-
-    if (current > 0) {
-      const auto phase = phase_.load(std::memory_order::relaxed);
-      wait_signal_.wait(lock, [this, phase] {
-        return (phase - phase_.load(std::memory_order::acquire)) < 0;
-      });
+    if (current_.fetch_sub(1, std::memory_order::acq_rel) > 1) {
+      SpinWait(phase_, phase);
     } else {
       const auto total = total_.load(std::memory_order::acquire);
       current_.store(total, std::memory_order::release);
 
-      ++phase_;
-
-      wait_signal_.notify_all();
+      phase_.fetch_add(1, std::memory_order::release);
+      phase_.notify_all();
     }
   }
 
@@ -50,9 +76,8 @@ class Barrier {
  private:
   std::atomic<I64> total_{};
   std::atomic<I64> current_{};
-  std::atomic<I64> phase_{};
-  std::mutex wait_mutex_{};
-  std::condition_variable wait_signal_{};
+  // Kept at 32 bits so that waiting maps directly onto a futex
+  std::atomic<U32> phase_{};
 };
 
-#endif  // INTEGRAL_BARRIER_H
\ No newline at end of file
+#endif  // INTEGRAL_BARRIER_H
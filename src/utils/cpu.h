@@ -0,0 +1,111 @@
+#ifndef INTEGRAL_CPU_H
+#define INTEGRAL_CPU_H
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define INTEGRAL_HAS_CPUID 1
+#include <cpuid.h>
+#else
+#define INTEGRAL_HAS_CPUID 0
+#endif
+
+namespace cpu {
+
+// Whether the CPU supports BMI2, regardless of what the build targets
+[[nodiscard]] inline bool HasBmi2() {
+#if INTEGRAL_HAS_CPUID
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return ebx & bit_BMI2;
+#else
+  return false;
+#endif
+}
+
+// Whether PEXT runs in hardware. AMD processors before Zen 3 (families 0x15
+// through 0x17) implement it in microcode with a latency that grows with the
+// number of set bits in the mask, which makes it slower than a magic multiply
+[[nodiscard]] inline bool HasFastPext() {
+#if INTEGRAL_HAS_CPUID
+  if (!HasBmi2()) return false;
+
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) return false;
+  const bool is_amd = ebx == signature_AMD_ebx && ecx == signature_AMD_ecx &&
+                      edx == signature_AMD_edx;
+  if (!is_amd) return true;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  int family = (eax >> 8) & 0xF;
+  if (family == 0xF) family += (eax >> 20) & 0xFF;
+  return family >= 0x19;
+#else
+  return false;
+#endif
+}
+
+// Whether the OS saves every one of the given register states (bits of XCR0)
+// on context switches, without which the registers can't be used even if the
+// CPU has them
+[[nodiscard]] inline bool OsSavesRegisters(unsigned state_mask) {
+#if INTEGRAL_HAS_CPUID
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  if (!(ecx & bit_OSXSAVE)) return false;
+
+  unsigned xcr0, xcr0_high;
+  asm("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+  return (xcr0 & state_mask) == state_mask;
+#else
+  return false;
+#endif
+}
+
+// Whether the CPU supports AVX2 along with FMA, and the OS saves the YMM
+// registers
+[[nodiscard]] inline bool HasAvx2() {
+#if INTEGRAL_HAS_CPUID
+  // The SSE and AVX states
+  if (!OsSavesRegisters(0x6)) return false;
+
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  if (!(ecx & bit_FMA)) return false;
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return ebx & bit_AVX2;
+#else
+  return false;
+#endif
+}
+
+// Whether the CPU supports AVX-512 with byte and word instructions, and the OS
+// saves the ZMM and mask registers
+[[nodiscard]] inline bool HasAvx512() {
+#if INTEGRAL_HAS_CPUID
+  // The SSE, AVX, opmask and upper ZMM states
+  if (!HasAvx2() || !OsSavesRegisters(0xE6)) return false;
+
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return (ebx & bit_AVX512F) && (ebx & bit_AVX512BW);
+#else
+  return false;
+#endif
+}
+
+[[nodiscard]] inline bool HasAvx512Vnni() {
+#if INTEGRAL_HAS_CPUID
+  if (!HasAvx512()) return false;
+
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  return ecx & bit_AVX512VNNI;
+#else
+  return false;
+#endif
+}
+
+}  // namespace cpu
+
+#endif  // INTEGRAL_CPU_H
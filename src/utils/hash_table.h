@@ -7,46 +7,12 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "large_pages.h"
 #include "types.h"
 
-#if defined(__linux__)
-#include <sys/mman.h>
-#endif
-
-inline void* aligned_alloc_wrapper(size_t alignment, size_t size) {
-  void* ptr = nullptr;
-
-#if defined(_MSC_VER) || defined(__MINGW32__)
-  ptr = _aligned_malloc(size, alignment);
-  if (!ptr) throw std::bad_alloc();
-#elif defined(__APPLE__)
-  // macOS doesn't have std::aligned_alloc until C++17
-  if (posix_memalign(&ptr, alignment, size)) throw std::bad_alloc();
-#else
-  if (size % alignment != 0) {
-    size += alignment - (size % alignment);  // pad to alignment
-  }
-  ptr = std::aligned_alloc(alignment, size);
-  if (!ptr) throw std::bad_alloc();
-#endif
-
-#if defined(__linux__)
-  madvise(ptr, size, MADV_HUGEPAGE);  // optional perf boost
-#endif
-
-  return ptr;
-}
-
-inline void aligned_free(void* ptr) {
-#if defined(_MSC_VER) || defined(__MINGW32__)
-  _aligned_free(ptr);
-#else
-  std::free(ptr);
-#endif
-}
-
 template <typename T>
 class AlignedHashTable {
  public:
@@ -57,9 +23,7 @@ class AlignedHashTable {
   AlignedHashTable() : table_(nullptr), table_size_(0) {}
 
   ~AlignedHashTable() {
-    if (table_) {
-      aligned_free(table_);
-    }
+    memory::FreeLargePages(allocation_);
   }
 
   void Resize(std::size_t mb_size) {
@@ -71,15 +35,41 @@ class AlignedHashTable {
     std::size_t num_elements = mb_size / sizeof(T);
     std::size_t alignment = sizeof(T);
 
-    const auto new_table = static_cast<T*>(
-        aligned_alloc_wrapper(alignment, num_elements * sizeof(T)));
+    const auto allocation =
+        memory::AllocateLargePages(num_elements * sizeof(T), alignment);
+
+    memory::FreeLargePages(allocation_);
+    allocation_ = allocation;
+    table_ = static_cast<T*>(allocation.ptr);
+    table_size_ = num_elements;
+  }
 
-    if (table_) {
-      aligned_free(table_);
+  // Uses a file mapping as the table, where the table starts at the given
+  // byte offset into the file. Returns false if the file couldn't be mapped
+  bool MapFile(const std::string& path, std::size_t offset) {
+#if defined(__linux__) || defined(__APPLE__)
+    const auto allocation = memory::MapFile(path);
+    if (!allocation.ptr || allocation.size < offset + sizeof(T)) {
+      memory::FreeLargePages(allocation);
+      return false;
     }
 
-    table_ = new_table;
-    table_size_ = num_elements;
+    memory::FreeLargePages(allocation_);
+    allocation_ = allocation;
+    table_ = reinterpret_cast<T*>(static_cast<char*>(allocation.ptr) + offset);
+    table_size_ = (allocation.size - offset) / sizeof(T);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  [[nodiscard]] memory::PageType GetPageType() const {
+    return memory::BackingPageType(allocation_);
+  }
+
+  [[nodiscard]] std::size_t GetSize() const {
+    return table_size_;
   }
 
   void Clear() {
@@ -101,6 +91,7 @@ class AlignedHashTable {
   }
 
  protected:
+  memory::LargePageAllocation allocation_;
   T* table_ = nullptr;
   std::size_t table_size_ = 0;
 };
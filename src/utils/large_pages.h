@@ -0,0 +1,344 @@
+#ifndef INTEGRAL_LARGE_PAGES_H
+#define INTEGRAL_LARGE_PAGES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "types.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+namespace memory {
+
+constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr std::size_t kGiganticPageSize = 1024 * 1024 * 1024;
+
+enum class PageType {
+  kNormal,
+  kTransparentHuge,
+  kTransparentHugeRequested,
+  kHuge2MB,
+  kHuge1GB,
+  kFileMapping,
+};
+
+[[nodiscard]] inline std::string_view PageTypeName(PageType type) {
+  switch (type) {
+    case PageType::kHuge1GB:
+      return "1GB huge pages";
+    case PageType::kHuge2MB:
+      return "2MB huge pages";
+    case PageType::kTransparentHuge:
+      return "transparent huge pages";
+    case PageType::kTransparentHugeRequested:
+      return "normal pages (THP requested)";
+    case PageType::kFileMapping:
+      return "a file mapping";
+    default:
+      return "normal pages";
+  }
+}
+
+// Describes a block of memory and how it was obtained, which determines how it
+// has to be released
+struct LargePageAllocation {
+  void *ptr = nullptr;
+  std::size_t size = 0;
+  PageType type = PageType::kNormal;
+  bool mapped = false;
+};
+
+[[nodiscard]] inline std::size_t RoundUp(std::size_t size,
+                                         std::size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+inline void *AlignedAlloc(std::size_t alignment, std::size_t size) {
+  void *ptr = nullptr;
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+  ptr = _aligned_malloc(size, alignment);
+#elif defined(__APPLE__)
+  if (posix_memalign(&ptr, alignment, size)) ptr = nullptr;
+#else
+  ptr = std::aligned_alloc(alignment, RoundUp(size, alignment));
+#endif
+
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+inline void AlignedFree(void *ptr) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+#if defined(__linux__)
+// Attempts to map memory from the hugetlb pool, which only succeeds if the
+// administrator reserved enough pages of the requested size
+[[nodiscard]] inline LargePageAllocation MapHugePages(std::size_t size,
+                                                      std::size_t page_size,
+                                                      int page_flag,
+                                                      PageType type) {
+  const auto mapped_size = RoundUp(size, page_size);
+  void *ptr = mmap(nullptr,
+                   mapped_size,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag,
+                   -1,
+                   0);
+  if (ptr == MAP_FAILED) return {};
+  return {ptr, mapped_size, type, true};
+}
+
+[[nodiscard]] inline bool TransparentHugePagesEnabled() {
+  static const bool enabled = []() {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    return std::getline(file, mode) &&
+           mode.find("[never]") == std::string::npos;
+  }();
+  return enabled;
+}
+
+// Returns how many bytes of the mapping that contains the given address are
+// backed by transparent huge pages, according to /proc/self/smaps
+[[nodiscard]] inline std::size_t TransparentHugePageBytes(const void *ptr) {
+  const auto address = reinterpret_cast<std::uintptr_t>(ptr);
+  std::ifstream file("/proc/self/smaps");
+  std::string line;
+  bool in_mapping = false;
+  while (std::getline(file, line)) {
+    // Every mapping starts with a line like "7f0000000000-7f0000200000 rw-p"
+    const auto dash = line.find('-');
+    const auto space = line.find(' ');
+    if (dash != std::string::npos && space != std::string::npos &&
+        dash < space && line.find(':') > space) {
+      const auto start = std::stoull(line.substr(0, dash), nullptr, 16);
+      const auto end =
+          std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16);
+      in_mapping = start <= address && address < end;
+      continue;
+    }
+
+    constexpr std::string_view kField = "AnonHugePages:";
+    if (in_mapping && line.starts_with(kField)) {
+      return std::stoull(line.substr(kField.size())) * 1024;
+    }
+  }
+  return 0;
+}
+#endif
+
+// Allocates memory backed by the largest pages that are available, falling
+// back from 1GB to 2MB huge pages, then to transparent huge pages and finally
+// to normal pages. Small allocations always use normal pages since rounding
+// them up to a huge page would mostly waste memory
+[[nodiscard]] inline LargePageAllocation AllocateLargePages(
+    std::size_t size, std::size_t alignment = 64) {
+#if defined(__linux__)
+  if (size >= kGiganticPageSize) {
+    const auto allocation =
+        MapHugePages(size, kGiganticPageSize, MAP_HUGE_1GB, PageType::kHuge1GB);
+    if (allocation.ptr) return allocation;
+  }
+
+  if (size >= kHugePageSize) {
+    const auto allocation =
+        MapHugePages(size, kHugePageSize, MAP_HUGE_2MB, PageType::kHuge2MB);
+    if (allocation.ptr) return allocation;
+
+    if (TransparentHugePagesEnabled()) {
+      // Aligning to the huge page size lets the kernel back the whole block
+      // with transparent huge pages
+      const auto aligned_size = RoundUp(size, kHugePageSize);
+      void *ptr = AlignedAlloc(kHugePageSize, aligned_size);
+      madvise(ptr, aligned_size, MADV_HUGEPAGE);
+      return {ptr, aligned_size, PageType::kTransparentHugeRequested, false};
+    }
+  }
+#endif
+
+  return {AlignedAlloc(alignment, size), size, PageType::kNormal, false};
+}
+
+// Returns the pages that back an allocation. The kernel only picks transparent
+// huge pages once memory is first touched and may still fall back to normal
+// pages, so they are reported as requested until all of the memory is backed
+[[nodiscard]] inline PageType BackingPageType(
+    const LargePageAllocation &allocation) {
+#if defined(__linux__)
+  if (allocation.type == PageType::kTransparentHugeRequested &&
+      TransparentHugePageBytes(allocation.ptr) >= allocation.size) {
+    return PageType::kTransparentHuge;
+  }
+#endif
+  return allocation.type;
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+enum class FileAccess {
+  // Writes stay private to this process
+  kPrivate,
+  // The pages can't be written, and are shared through the page cache with
+  // every process that maps the same file
+  kSharedReadOnly,
+};
+
+// Maps a whole file into memory. Pages are only read from disk once they are
+// first accessed
+[[nodiscard]] inline LargePageAllocation MapFile(
+    const std::string &path, FileAccess access = FileAccess::kPrivate) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return {};
+
+  struct stat file_stat {};
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    return {};
+  }
+
+  const auto size = static_cast<std::size_t>(file_stat.st_size);
+  const bool is_private = access == FileAccess::kPrivate;
+  const int protection = is_private ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *ptr = mmap(nullptr,
+                   size,
+                   protection,
+                   is_private ? MAP_PRIVATE : MAP_SHARED,
+                   fd,
+                   0);
+  close(fd);
+
+  if (ptr == MAP_FAILED) return {};
+
+#if defined(__linux__)
+  // Files on hugetlbfs are always backed by huge pages, while the kernel may
+  // collapse the pages of other read-only mappings into transparent ones
+  if (access == FileAccess::kSharedReadOnly && TransparentHugePagesEnabled()) {
+    madvise(ptr, size, MADV_HUGEPAGE);
+  }
+#endif
+
+  return {ptr, size, PageType::kFileMapping, true};
+}
+#endif
+
+inline void FreeLargePages(const LargePageAllocation &allocation) {
+  if (!allocation.ptr) return;
+
+#if defined(__linux__) || defined(__APPLE__)
+  if (allocation.mapped) {
+    munmap(allocation.ptr, allocation.size);
+    return;
+  }
+#endif
+
+  AlignedFree(allocation.ptr);
+}
+
+// Owning pointer to an object that lives in memory from AllocateLargePages()
+template <typename T>
+class LargePagePtr {
+ public:
+  LargePagePtr() = default;
+
+  explicit LargePagePtr(const LargePageAllocation &allocation)
+      : allocation_(allocation) {}
+
+  LargePagePtr(LargePagePtr &&other) noexcept
+      : allocation_(other.allocation_) {
+    other.allocation_ = {};
+  }
+
+  LargePagePtr &operator=(LargePagePtr &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      allocation_ = other.allocation_;
+      other.allocation_ = {};
+    }
+    return *this;
+  }
+
+  LargePagePtr(const LargePagePtr &) = delete;
+  LargePagePtr &operator=(const LargePagePtr &) = delete;
+
+  ~LargePagePtr() {
+    Reset();
+  }
+
+  void Reset() {
+    if (allocation_.ptr) {
+      get()->~T();
+      FreeLargePages(allocation_);
+      allocation_ = {};
+    }
+  }
+
+  [[nodiscard]] T *get() const {
+    return static_cast<T *>(allocation_.ptr);
+  }
+
+  T *operator->() const {
+    return get();
+  }
+
+  T &operator*() const {
+    return *get();
+  }
+
+  explicit operator bool() const {
+    return allocation_.ptr != nullptr;
+  }
+
+  [[nodiscard]] PageType GetPageType() const {
+    return BackingPageType(allocation_);
+  }
+
+ private:
+  LargePageAllocation allocation_;
+};
+
+template <typename T, typename... Args>
+[[nodiscard]] LargePagePtr<T> MakeLargePageUnique(Args &&...args) {
+  const auto allocation =
+      AllocateLargePages(sizeof(T), std::max<std::size_t>(alignof(T), 64));
+  try {
+    new (allocation.ptr) T(std::forward<Args>(args)...);
+  } catch (...) {
+    FreeLargePages(allocation);
+    throw;
+  }
+  return LargePagePtr<T>(allocation);
+}
+
+}  // namespace memory
+
+#endif  // INTEGRAL_LARGE_PAGES_H
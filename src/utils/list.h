@@ -39,6 +39,10 @@ class List {
     return container_[count_ - 1];
   }
 
+  inline const T &Back() const {
+    return container_[count_ - 1];
+  }
+
   inline void Erase(int i) {
     std::swap(Back(), container_[i]);
     --count_;
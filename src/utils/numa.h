@@ -0,0 +1,136 @@
+#ifndef INTEGRAL_NUMA_H
+#define INTEGRAL_NUMA_H
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace numa {
+
+// A NUMA node along with the logical CPUs that belong to it
+struct Node {
+  int id;
+  std::vector<int> cpus;
+};
+
+// Parses a Linux CPU list such as "0-7,16-23" into the individual CPU indices
+inline std::vector<int> ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+
+    const auto dash = range.find('-');
+    try {
+      const int first = std::stoi(range.substr(0, dash));
+      const int last =
+          dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    } catch (...) {
+      return {};
+    }
+  }
+
+  return cpus;
+}
+
+inline std::vector<Node> DetectNodes() {
+  std::vector<Node> nodes;
+
+#if defined(__linux__)
+  namespace fs = std::filesystem;
+
+  // Only consider the CPUs that the process is allowed to run on, so that
+  // restricting the engine with taskset or cgroups is respected
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  const bool has_affinity =
+      sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0;
+
+  std::error_code error;
+  for (const auto &entry :
+       fs::directory_iterator("/sys/devices/system/node", error)) {
+    const auto name = entry.path().filename().string();
+    if (name.size() <= 4 || name.rfind("node", 0) != 0 ||
+        !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+      continue;
+    }
+
+    std::ifstream file(entry.path() / "cpulist");
+    std::string cpu_list;
+    if (!file || !std::getline(file, cpu_list)) continue;
+
+    Node node{std::stoi(name.substr(4)), {}};
+    for (const int cpu : ParseCpuList(cpu_list)) {
+      if (!has_affinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+        node.cpus.push_back(cpu);
+      }
+    }
+
+    // Memory-only nodes have no CPUs to run search threads on
+    if (!node.cpus.empty()) nodes.push_back(std::move(node));
+  }
+
+  std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) {
+    return a.id < b.id;
+  });
+#endif
+
+  // Treat the machine as a single node if the topology isn't exposed
+  if (nodes.empty()) {
+    nodes.push_back({0, {}});
+  }
+
+  return nodes;
+}
+
+// Returns the NUMA nodes that search threads can be placed on
+inline const std::vector<Node> &GetNodes() {
+  static const auto nodes = DetectNodes();
+  return nodes;
+}
+
+[[nodiscard]] inline int NodeCount() {
+  return static_cast<int>(GetNodes().size());
+}
+
+// Spreads search threads across the nodes in a round-robin fashion, which
+// keeps the main thread on the first node and balances the helpers
+[[nodiscard]] inline int NodeForThread(int thread_id) {
+  return thread_id % NodeCount();
+}
+
+// Restricts the calling thread to the CPUs of the given node (an index into
+// GetNodes()). Memory that the thread touches first afterwards will be
+// allocated by the kernel on that node
+inline bool BindThisThread(int node_idx) {
+#if defined(__linux__)
+  const auto &node = GetNodes()[node_idx];
+  if (node.cpus.empty()) return false;
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const int cpu : node.cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpu_set);
+  }
+
+  return pthread_setaffinity_np(
+             pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace numa
+
+#endif  // INTEGRAL_NUMA_H
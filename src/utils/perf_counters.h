@@ -0,0 +1,257 @@
+#ifndef INTEGRAL_PERF_COUNTERS_H
+#define INTEGRAL_PERF_COUNTERS_H
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "types.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf {
+
+enum Event {
+  kCycles,
+  kInstructions,
+  kL1dMisses,
+  kLlcMisses,
+  kDtlbMisses,
+  kBranchMisses,
+  kNumEvents
+};
+
+constexpr std::array<std::string_view, kNumEvents> kEventNames = {
+    "cycles",
+    "instructions",
+    "L1d misses",
+    "LLC misses",
+    "dTLB misses",
+    "branch misses",
+};
+
+// Event counts over some period of time. Events that the CPU or the kernel
+// doesn't support are marked as unavailable
+struct Counts {
+  std::array<U64, kNumEvents> values{};
+  std::array<bool, kNumEvents> available{};
+
+  Counts &operator+=(const Counts &other) {
+    for (int event = 0; event < kNumEvents; event++) {
+      values[event] += other.values[event];
+      available[event] |= other.available[event];
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool AnyAvailable() const {
+    for (const bool event_available : available) {
+      if (event_available) return true;
+    }
+    return false;
+  }
+
+  [[nodiscard]] double InstructionsPerCycle() const {
+    return values[kCycles] ? static_cast<double>(values[kInstructions]) /
+                                 values[kCycles]
+                           : 0.0;
+  }
+};
+
+// Hardware performance counters of the thread that opened them, read through
+// perf_event_open on Linux. Only user space is counted, which works with the
+// default perf_event_paranoid setting. The events are opened independently so
+// that the kernel can multiplex them when there are more events than hardware
+// counters, and the counts are scaled up by the fraction of time each event
+// was actually counted
+class CounterGroup {
+ public:
+  CounterGroup() {
+    fds_.fill(-1);
+  }
+
+  ~CounterGroup() {
+    Close();
+  }
+
+  CounterGroup(const CounterGroup &) = delete;
+  CounterGroup &operator=(const CounterGroup &) = delete;
+
+  // Opens the counters for the calling thread in a disabled state, returning
+  // whether any of the events is available
+  bool Open() {
+    Close();
+
+#if defined(__linux__)
+    for (int event = 0; event < kNumEvents; event++) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      SetEventType(attr, static_cast<Event>(event));
+
+      fds_[event] = static_cast<int>(syscall(
+          SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+      if (fds_[event] < 0 && error_.empty()) {
+        error_ = DescribeError(errno);
+      }
+    }
+#else
+    error_ = "not supported on this platform";
+#endif
+
+    return IsOpen();
+  }
+
+  void Close() {
+#if defined(__linux__)
+    for (int &fd : fds_) {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+#endif
+    error_.clear();
+  }
+
+  [[nodiscard]] bool IsOpen() const {
+    for (const int fd : fds_) {
+      if (fd >= 0) return true;
+    }
+    return false;
+  }
+
+  // Reason why the first unavailable event couldn't be opened
+  [[nodiscard]] const std::string &GetError() const {
+    return error_;
+  }
+
+  void Enable() {
+    Control(Command::kEnable);
+  }
+
+  void Disable() {
+    Control(Command::kDisable);
+  }
+
+  void Reset() {
+    Control(Command::kReset);
+  }
+
+  // Reads the counts since the last reset. Counting has to be disabled, or
+  // else the counts may be off by the cost of the read itself
+  [[nodiscard]] Counts Read() const {
+    Counts counts;
+
+#if defined(__linux__)
+    for (int event = 0; event < kNumEvents; event++) {
+      if (fds_[event] < 0) continue;
+
+      struct {
+        U64 value, time_enabled, time_running;
+      } data{};
+      if (read(fds_[event], &data, sizeof(data)) != sizeof(data)) continue;
+
+      counts.available[event] = true;
+      if (data.time_running > 0) {
+        counts.values[event] = static_cast<U64>(
+            static_cast<double>(data.value) * data.time_enabled /
+            data.time_running);
+      }
+    }
+#endif
+
+    return counts;
+  }
+
+  // Reads the counts and starts counting from zero again
+  Counts Take() {
+    const auto counts = Read();
+    Reset();
+    return counts;
+  }
+
+ private:
+  enum class Command {
+    kEnable,
+    kDisable,
+    kReset
+  };
+
+#if defined(__linux__)
+  [[nodiscard]] static std::string DescribeError(int error) {
+    switch (error) {
+      case ENOENT:
+      case EOPNOTSUPP:
+        return "the event isn't supported by this CPU, which is common in "
+               "virtual machines";
+      case EACCES:
+      case EPERM:
+        return "permission denied, see /proc/sys/kernel/perf_event_paranoid";
+      default:
+        return std::strerror(error);
+    }
+  }
+
+  static void SetEventType(perf_event_attr &attr, Event event) {
+    const auto cache_miss = [&attr](U64 cache) {
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+      case kCycles:
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case kInstructions:
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case kL1dMisses:
+        cache_miss(PERF_COUNT_HW_CACHE_L1D);
+        break;
+      case kLlcMisses:
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+      case kDtlbMisses:
+        cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+        break;
+      default:
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+  }
+#endif
+
+  void Control([[maybe_unused]] Command command) {
+#if defined(__linux__)
+    unsigned long request = PERF_EVENT_IOC_RESET;
+    if (command == Command::kEnable) {
+      request = PERF_EVENT_IOC_ENABLE;
+    } else if (command == Command::kDisable) {
+      request = PERF_EVENT_IOC_DISABLE;
+    }
+
+    for (const int fd : fds_) {
+      if (fd >= 0) ioctl(fd, request, 0);
+    }
+#endif
+  }
+
+  std::array<int, kNumEvents> fds_;
+  std::string error_;
+};
+
+}  // namespace perf
+
+#endif  // INTEGRAL_PERF_COUNTERS_H
@@ -1,6 +1,7 @@
 #ifndef INTEGRAL_RANDOM_H
 #define INTEGRAL_RANDOM_H
 
+#include <array>
 #include <random>
 
 #include "types.h"
@@ -30,4 +31,47 @@ static U64 RandomU64(U64 min, U64 max) {
   return dist(mt_generator);
 }
 
+// Produces the same sequence as std::mt19937_64, but can run at compile time,
+// so that tables of random numbers can be built during compilation
+class ConstexprMt19937_64 {
+ public:
+  constexpr explicit ConstexprMt19937_64(U64 seed) {
+    state_[0] = seed;
+    for (int i = 1; i < kStateSize; i++) {
+      state_[i] = kInitMultiplier * (state_[i - 1] ^ (state_[i - 1] >> 62)) + i;
+    }
+  }
+
+  constexpr U64 operator()() {
+    if (index_ == kStateSize) Twist();
+
+    U64 value = state_[index_++];
+    value ^= (value >> 29) & 0x5555555555555555ULL;
+    value ^= (value << 17) & 0x71D67FFFEDA60000ULL;
+    value ^= (value << 37) & 0xFFF7EEE000000000ULL;
+    value ^= value >> 43;
+    return value;
+  }
+
+ private:
+  static constexpr int kStateSize = 312;
+  static constexpr int kMiddleWord = 156;
+  static constexpr U64 kInitMultiplier = 6364136223846793005ULL;
+  static constexpr U64 kTwistMatrix = 0xB5026F5AA96619E9ULL;
+  static constexpr U64 kUpperMask = ~0ULL << 31;
+
+  constexpr void Twist() {
+    for (int i = 0; i < kStateSize; i++) {
+      const U64 value = (state_[i] & kUpperMask) |
+                        (state_[(i + 1) % kStateSize] & ~kUpperMask);
+      state_[i] = state_[(i + kMiddleWord) % kStateSize] ^ (value >> 1) ^
+                  (value & 1 ? kTwistMatrix : 0);
+    }
+    index_ = 0;
+  }
+
+  std::array<U64, kStateSize> state_{};
+  int index_ = kStateSize;
+};
+
 #endif  // INTEGRAL_RANDOM_H
\ No newline at end of file
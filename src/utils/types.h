@@ -41,9 +41,15 @@ enum class PromotionType : U8 {
 };
 
 enum MoveGenType : U8 {
-  kQuiet = 0b01,
-  kNoisy = 0b10,
+  kQuiet = 0b001,
+  kNoisy = 0b010,
   kAll = kQuiet | kNoisy,
+  // Combined with the other types to only generate moves that don't leave the
+  // king in check
+  kLegal = 0b100,
+  kLegalQuiet = kLegal | kQuiet,
+  kLegalNoisy = kLegal | kNoisy,
+  kLegalAll = kLegal | kAll,
 };
 
 enum Color : U8 {
@@ -15,47 +15,48 @@ using CastleRightsTable = std::array<U64, 16>;
 using EnPassantTable = std::array<U64, 8>;
 using FiftyMoveTable = std::array<U64, 100>;
 
-const auto turn = RandomU64();
+struct Keys {
+  U64 turn;
+  PieceTable pieces;
+  CastleRightsTable castle_rights;
+  EnPassantTable en_passant;
+  FiftyMoveTable fifty_move;
+};
 
-static PieceTable GeneratePieceTable() {
-  PieceTable piece_table;
-  for (auto& table : piece_table)
-    for (U64& entry : table) entry = RandomU64();
-  return piece_table;
-}
-
-const auto pieces = GeneratePieceTable();
+// The keys are drawn in the same order and from the same seed as the runtime
+// generator would, so they don't change by being built at compile time
+constexpr Keys GenerateKeys() {
+  ConstexprMt19937_64 random(kRandomSeed);
+  Keys keys{};
 
-static CastleRightsTable GenerateCastleRightsTable() {
-  CastleRightsTable castle_rights_table;
-  for (U64& entry : castle_rights_table) entry = RandomU64();
-  return castle_rights_table;
-}
+  keys.turn = random();
 
-const auto castle_rights = GenerateCastleRightsTable();
+  for (auto& table : keys.pieces)
+    for (U64& entry : table) entry = random();
 
-static EnPassantTable GenerateEnPassantTable() {
-  EnPassantTable en_passant_table;
-  for (U64& entry : en_passant_table) entry = RandomU64();
-  return en_passant_table;
-}
+  for (U64& entry : keys.castle_rights) entry = random();
 
-const auto en_passant = GenerateEnPassantTable();
+  for (U64& entry : keys.en_passant) entry = random();
 
-static FiftyMoveTable GenerateFiftyMoveTable() {
-  FiftyMoveTable fifty_move_table{};
   constexpr int kStep = 8;
   for (int i = 14; i < 100; i += kStep) {
-    const U64 key = RandomU64();
+    const U64 key = random();
     for (int j = 0; j < kStep; j++) {
       if (i + j >= 100) break;
-      fifty_move_table[i + j] = key;
+      keys.fifty_move[i + j] = key;
     }
   }
-  return fifty_move_table;
+
+  return keys;
 }
 
-const auto fifty_move = GenerateFiftyMoveTable();
+inline constexpr Keys kKeys = GenerateKeys();
+
+inline constexpr const U64& turn = kKeys.turn;
+inline constexpr const PieceTable& pieces = kKeys.pieces;
+inline constexpr const CastleRightsTable& castle_rights = kKeys.castle_rights;
+inline constexpr const EnPassantTable& en_passant = kKeys.en_passant;
+inline constexpr const FiftyMoveTable& fifty_move = kKeys.fifty_move;
 
 }  // namespace zobrist
 